@@ -0,0 +1,456 @@
+/**********************************************************************************************************************/
+/** Deferred binary logging for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * A TinyLog is a single producer, single consumer ring buffer: one thread logs into it, one (possibly different)
+ * thread consumes it. Use one TinyLog per producing thread.
+ *
+ * @file tiny_deferred.c
+ *
+ **********************************************************************************************************************/
+
+#ifdef TINY_PRINTF_TIMESTAMP
+// struct timespec is POSIX (C11 in <time.h>), strict ISO C builds only declare them with a feature test macro
+#if !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include "tiny_deferred.h"
+#include <string.h>
+#ifdef TINY_PRINTF_TIMESTAMP
+#include <time.h>
+#endif
+
+/// Maximum number of arguments of a deferred format
+#ifndef TINY_LOG_MAX_ARGS
+#define TINY_LOG_MAX_ARGS 16
+#endif
+/// Number of entries of the per thread format signature cache
+#ifndef TINY_LOG_SIGNATURE_CACHE
+#define TINY_LOG_SIGNATURE_CACHE 32
+#endif
+/// Storage class for per thread data
+#ifndef TINY_PRINTF_THREAD_LOCAL
+#define TINY_PRINTF_THREAD_LOCAL _Thread_local
+#endif
+
+/// Maximum number of operations of a deferred format
+#define TINY_LOG_MAX_OPS (2 * TINY_LOG_MAX_ARGS + 1)
+/// Round up to the record alignment
+#define TINY_LOG_ALIGN(x) (((x) + 7) & ~(size_t)7)
+/// Argument count marking padding up to the end of the buffer
+#define TINY_LOG_PADDING 0xFFFFFFFFu
+/// Signature type of the pointer argument of a hex dump, which is copied like strings
+#define TINY_LOG_ARG_HEX_DUMP 0x80
+/// Signature type of the struct timespec pointer of a timestamp, which is stored as nanoseconds since the epoch
+#define TINY_LOG_ARG_TIMESTAMP 0x81
+/// Stored timestamp of a NULL struct timespec pointer
+#define TINY_LOG_NULL_TIMESTAMP (-0x7FFFFFFFFFFFFFFFLL - 1)
+
+/// Positions are exchanged between producer and consumer with acquire / release semantics
+#define TINY_LOG_LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define TINY_LOG_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/**********************************************************************************************************************/
+/** Record header, followed by the arguments and the copied strings
+ **********************************************************************************************************************/
+typedef struct {
+  /// Size of the record including the header, the arguments and the strings
+  unsigned int size;
+  /// Number of arguments or TINY_LOG_PADDING
+  unsigned int count;
+  /// Format string
+  const char *format;
+} TinyLogRecord;
+
+/// Offset of the arguments in a record
+#define TINY_LOG_ARGS_OFFSET TINY_LOG_ALIGN(sizeof(TinyLogRecord))
+
+/**********************************************************************************************************************/
+/** Argument types of a format string
+ **********************************************************************************************************************/
+typedef struct {
+  /// Format string
+  const char *format;
+  /// Number of arguments
+  int count;
+  /// Argument types (TinyFormatArgType, TINY_LOG_ARG_HEX_DUMP or TINY_LOG_ARG_TIMESTAMP)
+  unsigned char types[TINY_LOG_MAX_ARGS];
+  /// Number of bytes of hex dumps and precision of strings (-1 for none), a negative number below -1 means the
+  /// argument that many positions before plus one gives it
+  int sizes[TINY_LOG_MAX_ARGS];
+  /// Set if a registered conversion takes a pointer argument, whose data cannot be copied
+  int pointers;
+} TinyLogSignature;
+
+/// Direct mapped cache of format signatures, one per thread so no locking is needed
+static TINY_PRINTF_THREAD_LOCAL TinyLogSignature tinyLogSignatures[TINY_LOG_SIGNATURE_CACHE];
+
+/**********************************************************************************************************************/
+/** Get the argument types of a format string
+ ***********************************************************************************************************************
+ *
+ * The format string is only compiled the first time it is seen (or after it has been evicted from the cache).
+ *
+ * @returns argument types or NULL if the format has too many arguments
+ *
+ **********************************************************************************************************************/
+static const TinyLogSignature *TinyLogGetSignature(
+  /// [in] Format string
+  const char *format)
+{
+  TinyLogSignature *signature = &tinyLogSignatures[((size_t)format >> 2) % TINY_LOG_SIGNATURE_CACHE];
+  TinyFormatOp ops[TINY_LOG_MAX_OPS];
+  TinyFormat compiled;
+  int i;
+
+  if(signature->format == format) {
+    return signature;
+  }
+
+  signature->format = NULL;
+  if(TinyFormatCompile(&compiled, ops, TINY_LOG_MAX_OPS, format) < 0) {
+    return NULL;
+  }
+  signature->pointers = 0;
+  for(signature->count = 0, i = 0; i < compiled.count; i++) {
+    TinyFormatArgType type = TinyFormatGetArgType(&ops[i]);
+    if(signature->count + TinyFormatGetArgCount(&ops[i]) > TINY_LOG_MAX_ARGS) {
+      return NULL;
+    }
+    if(ops[i].specifier != '\0' && ops[i].width == TINY_FORMAT_STAR) {
+      signature->types[signature->count++] = TINY_ARG_INT;
+    }
+    if(ops[i].specifier != '\0' && ops[i].precision == TINY_FORMAT_STAR) {
+      signature->types[signature->count++] = TINY_ARG_INT;
+    }
+    if(ops[i].specifier == 'h' || ops[i].specifier == 'H') {
+      // A '*' width is the argument in front of the pointer or in front of the '*' precision
+      signature->sizes[signature->count] = (ops[i].width != TINY_FORMAT_STAR) ? ops[i].width :
+                                           (ops[i].precision == TINY_FORMAT_STAR) ? -3 : -2;
+      signature->types[signature->count++] = TINY_LOG_ARG_HEX_DUMP;
+    }
+#ifdef TINY_PRINTF_TIMESTAMP
+    else if(ops[i].specifier == 'T' && type == TINY_ARG_POINTER) {
+      signature->types[signature->count++] = TINY_LOG_ARG_TIMESTAMP;
+    }
+#endif
+    else if(type != TINY_ARG_NONE) {
+      signature->pointers |= (type == TINY_ARG_POINTER && ops[i].specifier != 'p');
+      // Strings with a precision need not be terminated, they must not be read further when they are copied
+      signature->sizes[signature->count] = (ops[i].specifier != 's' || !(ops[i].options & TINY_FORMAT_PRECISION)) ? -1 :
+                                           (ops[i].precision == TINY_FORMAT_STAR) ? -2 : ops[i].precision;
+      signature->types[signature->count++] = (unsigned char)type;
+    }
+  }
+  signature->format = format;
+
+  return signature;
+}
+
+/**********************************************************************************************************************/
+/** Initialize a deferred log
+ ***********************************************************************************************************************
+ *
+ * @returns 0 or -1 if the size is not a power of two of at least 64 bytes
+ *
+ **********************************************************************************************************************/
+int TinyLogInit(
+  /// [out] Deferred log
+  TinyLog *log,
+  /// [in] Buffer, aligned to 8 bytes
+  void *buf,
+  /// [in] Size of the buffer, a power of two
+  size_t size,
+  /// [in] String argument policy
+  TinyLogStringPolicy strings,
+  /// [in] Maximum number of bytes copied of a string argument
+  size_t stringMax)
+{
+  if(size < 64 || (size & (size - 1)) != 0) {
+    return -1;
+  }
+
+  log->buf = buf;
+  log->size = size;
+  log->strings = strings;
+  log->stringMax = stringMax;
+  log->head = 0;
+  log->tail = 0;
+  log->dropped = 0;
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Record a printf call for later formatting
+ ***********************************************************************************************************************
+ *
+ * Only the format pointer and the arguments are stored, so the format string has to outlive the record. Depending on
+ * the string policy, string arguments and the bytes of "%*ph" hex dumps are copied into the record, at most stringMax
+ * bytes of each. The data behind the pointer argument of a registered conversion cannot be copied, with
+ * TINY_LOG_COPY_STRINGS such calls are dropped; with TINY_LOG_POINTER_STRINGS the data has to outlive the record.
+ *
+ * @returns 0 or -1 if the record was dropped (buffer full, too many arguments or pointer of a registered conversion)
+ *
+ **********************************************************************************************************************/
+int TinyLogVPrintf(
+  /// [in,out] Deferred log
+  TinyLog *log,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  va_list args)
+{
+  const TinyLogSignature *signature = TinyLogGetSignature(fmt);
+  TinyFormatArg argv[TINY_LOG_MAX_ARGS];
+  size_t lengths[TINY_LOG_MAX_ARGS];
+  size_t size, pos, pad, head, tail, strings;
+  TinyLogRecord *record;
+  va_list ap;
+  int i;
+
+  if(signature == NULL || (signature->pointers && log->strings == TINY_LOG_COPY_STRINGS)) {
+    __atomic_fetch_add(&log->dropped, 1, __ATOMIC_RELAXED);
+    return -1;
+  }
+
+  // Fetch the arguments and measure the strings to copy
+  size = strings = TINY_LOG_ARGS_OFFSET + signature->count * sizeof(TinyFormatArg);
+  va_copy(ap, args);
+  for(i = 0; i < signature->count; i++) {
+    lengths[i] = 0;
+    switch(signature->types[i]) {
+      case TINY_ARG_INT:
+        argv[i].i = va_arg(ap, int);
+        break;
+      case TINY_ARG_LONG_LONG:
+        argv[i].ll = va_arg(ap, long long int);
+        break;
+      case TINY_ARG_DOUBLE:
+        argv[i].f = va_arg(ap, double);
+        break;
+      case TINY_ARG_STRING:
+        argv[i].s = va_arg(ap, const char *);
+        if(log->strings == TINY_LOG_COPY_STRINGS && argv[i].s != NULL) {
+          size_t max = log->stringMax;
+          const char *end;
+          int precision = (signature->sizes[i] < -1) ? argv[i + signature->sizes[i] + 1].i : signature->sizes[i];
+          if(precision >= 0 && (size_t)precision < max) {
+            max = precision;
+          }
+          end = memchr(argv[i].s, '\0', max);
+          lengths[i] = (end != NULL) ? (size_t)(end - argv[i].s) : max;
+          size += lengths[i] + 1;
+        }
+        break;
+      case TINY_ARG_POINTER:
+        argv[i].p = va_arg(ap, const void *);
+        break;
+      case TINY_LOG_ARG_HEX_DUMP:
+        argv[i].p = va_arg(ap, const void *);
+        if(log->strings == TINY_LOG_COPY_STRINGS && argv[i].p != NULL) {
+          if(signature->sizes[i] < 0) {
+            // The length comes from a previous argument, limit it to the bytes copied (negative dumps nothing)
+            TinyFormatArg *width = &argv[i + signature->sizes[i] + 1];
+            int length = (width->i < 0) ? 0 : width->i;
+            lengths[i] = ((size_t)length > log->stringMax) ? log->stringMax : (size_t)length;
+            width->i = (int)lengths[i];
+          }
+          else {
+            // A fixed length is shortened when the record is consumed
+            lengths[i] = ((size_t)signature->sizes[i] > log->stringMax) ? log->stringMax : (size_t)signature->sizes[i];
+          }
+          size += lengths[i];
+        }
+        break;
+#ifdef TINY_PRINTF_TIMESTAMP
+      case TINY_LOG_ARG_TIMESTAMP:
+        {
+          // The struct timespec usually lives on the stack of the caller, store its value (years 1678 to 2261 fit)
+          const struct timespec *time = va_arg(ap, const struct timespec *);
+          long long int second = (time != NULL) ? (long long int)time->tv_sec : 0;
+          second = (second > 9223372035LL) ? 9223372035LL : (second < -9223372035LL) ? -9223372035LL : second;
+          argv[i].ll = (time != NULL) ? second * 1000000000 + time->tv_nsec : TINY_LOG_NULL_TIMESTAMP;
+        }
+        break;
+#endif
+    }
+  }
+  va_end(ap);
+  size = TINY_LOG_ALIGN(size);
+
+  // Reserve space, records do not wrap around the end of the buffer
+  head = log->head;
+  tail = TINY_LOG_LOAD_ACQUIRE(&log->tail);
+  pos = head & (log->size - 1);
+  pad = (pos + size > log->size) ? log->size - pos : 0;
+  if(pad + size > log->size - (head - tail)) {
+    __atomic_fetch_add(&log->dropped, 1, __ATOMIC_RELAXED);
+    return -1;
+  }
+  if(pad != 0) {
+    record = (TinyLogRecord *)(log->buf + pos);
+    record->size = (unsigned int)pad;
+    record->count = TINY_LOG_PADDING;
+    head += pad;
+    pos = 0;
+  }
+
+  record = (TinyLogRecord *)(log->buf + pos);
+  record->size = (unsigned int)size;
+  record->count = (unsigned int)signature->count;
+  record->format = fmt;
+
+  // Copy the strings behind the arguments, the arguments refer to them by their offset in the record
+  for(i = 0; i < signature->count; i++) {
+    if(signature->types[i] == TINY_ARG_STRING && log->strings == TINY_LOG_COPY_STRINGS) {
+      if(argv[i].s != NULL) {
+        memcpy((char *)record + strings, argv[i].s, lengths[i]);
+        ((char *)record)[strings + lengths[i]] = '\0';
+        argv[i].i = (int)strings;
+        strings += lengths[i] + 1;
+      }
+      else {
+        argv[i].i = 0;
+      }
+    }
+    else if(signature->types[i] == TINY_LOG_ARG_HEX_DUMP && log->strings == TINY_LOG_COPY_STRINGS) {
+      if(argv[i].p != NULL) {
+        memcpy((char *)record + strings, argv[i].p, lengths[i]);
+        argv[i].i = (int)strings;
+        strings += lengths[i];
+      }
+      else {
+        argv[i].i = 0;
+      }
+    }
+  }
+  memcpy((char *)record + TINY_LOG_ARGS_OFFSET, argv, signature->count * sizeof(TinyFormatArg));
+
+  TINY_LOG_STORE_RELEASE(&log->head, head + size);
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Record a printf call for later formatting
+ ***********************************************************************************************************************
+ *
+ * @returns 0 or -1 if the record was dropped (buffer full or too many arguments)
+ *
+ **********************************************************************************************************************/
+int TinyLogPrintf(
+  /// [in,out] Deferred log
+  TinyLog *log,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int ret;
+
+  va_start(va, fmt);
+  ret = TinyLogVPrintf(log, fmt, va);
+  va_end(va);
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Format recorded printf calls
+ ***********************************************************************************************************************
+ *
+ * Runs the recorded calls through the regular TinyPrintf engine, typically from a background thread.
+ *
+ * @returns number of records formatted
+ *
+ **********************************************************************************************************************/
+int TinyLogConsume(
+  /// [in,out] Deferred log
+  TinyLog *log,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Maximum number of records to format (negative for no limit)
+  int maxRecords)
+{
+  TinyFormatOp ops[TINY_LOG_MAX_OPS];
+  TinyFormatArg argv[TINY_LOG_MAX_ARGS];
+#ifdef TINY_PRINTF_TIMESTAMP
+  struct timespec times[TINY_LOG_MAX_ARGS];
+#endif
+  TinyFormat compiled;
+  size_t tail = log->tail, head = TINY_LOG_LOAD_ACQUIRE(&log->head);
+  int records = 0;
+
+  while(tail != head && records != maxRecords) {
+    TinyLogRecord *record = (TinyLogRecord *)(log->buf + (tail & (log->size - 1)));
+
+    if(record->count != TINY_LOG_PADDING) {
+      TinyFormatOp *op;
+      unsigned int i = 0;
+
+      memcpy(argv, (char *)record + TINY_LOG_ARGS_OFFSET, record->count * sizeof(TinyFormatArg));
+      TinyFormatCompile(&compiled, ops, TINY_LOG_MAX_OPS, record->format);
+      for(op = ops; op != ops + compiled.count; op++) {
+        TinyFormatArgType type = TinyFormatGetArgType(op);
+        // Skip the '*' width and precision
+        i += TinyFormatGetArgCount(op) - (type != TINY_ARG_NONE);
+        // Point copied strings into the record, it stays untouched until the tail is moved
+        if(log->strings == TINY_LOG_COPY_STRINGS &&
+           (type == TINY_ARG_STRING || op->specifier == 'h' || op->specifier == 'H')) {
+          argv[i].s = (argv[i].i != 0) ? (const char *)record + argv[i].i : NULL;
+          // Only stringMax bytes of a hex dump of fixed length were copied
+          if(type != TINY_ARG_STRING && op->width != TINY_FORMAT_STAR && (size_t)op->width > log->stringMax) {
+            op->width = (int)log->stringMax;
+          }
+        }
+#ifdef TINY_PRINTF_TIMESTAMP
+        // Unpack stored timestamps into a struct timespec again
+        else if(op->specifier == 'T' && type == TINY_ARG_POINTER) {
+          long long int nanoseconds = argv[i].ll;
+          times[i].tv_sec = (time_t)(nanoseconds / 1000000000);
+          times[i].tv_nsec = (long)(nanoseconds % 1000000000);
+          if(times[i].tv_nsec < 0) {
+            times[i].tv_nsec += 1000000000;
+            --times[i].tv_sec;
+          }
+          argv[i].p = (nanoseconds != TINY_LOG_NULL_TIMESTAMP) ? &times[i] : NULL;
+        }
+#endif
+        i += (type != TINY_ARG_NONE);
+      }
+      TinyFormatExecArgs(&compiled, printspan, ctx, argv);
+      records++;
+    }
+
+    tail += record->size;
+  }
+  // The space is released in one go to keep the cache line of the positions from bouncing between the threads
+  TINY_LOG_STORE_RELEASE(&log->tail, tail);
+
+  return records;
+}
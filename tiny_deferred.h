@@ -0,0 +1,74 @@
+/**********************************************************************************************************************/
+/** Deferred binary logging for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * A TinyLog is a single producer, single consumer ring buffer: one thread logs into it, one (possibly different)
+ * thread consumes it. Use one TinyLog per producing thread.
+ *
+ * @file tiny_deferred.h
+ *
+ **********************************************************************************************************************/
+
+#ifndef TINY_DEFERRED_H_
+#define TINY_DEFERRED_H_
+
+#include "tiny_printf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// String argument policies of a deferred log
+typedef enum {
+  /// Copy strings and hex dump bytes into the record, at most stringMax bytes of each
+  TINY_LOG_COPY_STRINGS,
+  /// Store the string pointers only, the strings have to outlive the record (e.g. string literals)
+  TINY_LOG_POINTER_STRINGS
+} TinyLogStringPolicy;
+
+/// Deferred log ring buffer
+typedef struct {
+  /// Buffer, aligned to 8 bytes
+  unsigned char *buf;
+  /// Size of the buffer, a power of two
+  size_t size;
+  /// String argument policy
+  TinyLogStringPolicy strings;
+  /// Maximum number of bytes copied of a string or hex dump argument
+  size_t stringMax;
+  /// Write position (free running, only changed by the producer)
+  size_t head;
+  /// Read position (free running, only changed by the consumer)
+  size_t tail;
+  /// Number of records dropped (buffer full, too many arguments or pointer of a registered conversion)
+  unsigned long dropped;
+} TinyLog;
+
+int TinyLogInit(TinyLog *log, void *buf, size_t size, TinyLogStringPolicy strings, size_t stringMax);
+int TinyLogVPrintf(TinyLog *log, const char *fmt, va_list args);
+int TinyLogPrintf(TinyLog *log, const char *fmt, ...);
+int TinyLogConsume(TinyLog *log, printspan_t printspan, void* ctx, int maxRecords);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //TINY_DEFERRED_H_
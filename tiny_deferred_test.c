@@ -0,0 +1,260 @@
+/**********************************************************************************************************************/
+/** Tiny printf deferred logging tests
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Hosted checks of the deferred log ring buffer, build and run them with:
+ * cc -pthread -DTINY_PRINTF_LONG_LONG -DTINY_PRINTF_FLOAT=double tiny_printf.c tiny_deferred.c tiny_deferred_test.c \
+ *    -o tiny_deferred_test
+ * ./tiny_deferred_test
+ *
+ * @file tiny_deferred_test.c
+ *
+ **********************************************************************************************************************/
+
+#include "tiny_deferred.h"
+#include "tiny_test.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+/// Records logged by the producer thread of TestThreads()
+#define TEST_THREAD_RECORDS 200000
+
+/**********************************************************************************************************************/
+/** Reallocate with the C library
+ **********************************************************************************************************************/
+static void *TestReallocate(
+  /// [in] Allocator context (unused)
+  void *ctx,
+  /// [in] Memory to resize, NULL to allocate
+  void *memory,
+  /// [in] New size, 0 to release
+  size_t size)
+{
+  (void)ctx;
+  if(size == 0) {
+    free(memory);
+    return NULL;
+  }
+  return realloc(memory, size);
+}
+
+/**********************************************************************************************************************/
+/** Consume all records of a log into a builder
+ ***********************************************************************************************************************
+ *
+ * @returns the consumed output (valid until the builder is reset), an empty string if there was none
+ *
+ **********************************************************************************************************************/
+static const char *TestConsume(
+  /// [in,out] Deferred log
+  TinyLog *log,
+  /// [in,out] Builder, reset first
+  TinyBuilder *builder)
+{
+  TinyBuilderReset(builder);
+  TinyLogConsume(log, TinyBuilderSpan, builder, -1);
+
+  return (builder->string != NULL) ? builder->string : "";
+}
+
+/**********************************************************************************************************************/
+/** Custom conversion printing the int a pointer argument points to
+ **********************************************************************************************************************/
+static int TestConvertIntPointer(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  return TinyFormatInteger(printspan, ctx, *(const int *)arg->p, 10, 1, op->width, op->options, 'a');
+}
+
+/**********************************************************************************************************************/
+/** Arguments are stored when logging and formatted when consuming
+ **********************************************************************************************************************/
+static void TestArguments(void)
+{
+  static unsigned long long int buf[64];
+  static const unsigned char bytes[8] = { 0x00, 0x01, 0x02, 0x03, 0xfc, 0xfd, 0xfe, 0xff };
+  static const char letters[3] = { 'a', 'b', 'c' };
+  char string[16] = "original";
+  TinyBuilder builder;
+  TinyLog log;
+  int value = 42;
+
+  TinyBuilderInit(&builder, TestReallocate, NULL);
+  TEST_CHECK(TinyLogInit(&log, buf, 100, TINY_LOG_COPY_STRINGS, 4) == -1);
+  TEST_CHECK(TinyLogInit(&log, buf, sizeof(buf), TINY_LOG_COPY_STRINGS, 4) == 0);
+
+  // Copied strings survive the caller changing them, at most stringMax bytes are copied
+  TEST_CHECK(TinyLogPrintf(&log, "%d %lld %x %s|%.3s|%s\n", -7, -1234567890123ll, 255u, string, letters,
+                           (const char *)NULL) == 0);
+  strcpy(string, "changed");
+  TEST_CHECK(TinyLogPrintf(&log, "[%*ph][%*phC][%2ph][%8ph]\n", 3, bytes, -3, bytes, bytes + 4, bytes) == 0);
+  TEST_STRING(TestConsume(&log, &builder), "-7 -1234567890123 ff orig|abc|(null)\n[000102][][fcfd][00010203]\n");
+#ifdef TINY_PRINTF_FLOAT
+  TEST_CHECK(TinyLogPrintf(&log, "%.2f %g\n", 2.5, 1e-300) == 0);
+  TEST_STRING(TestConsume(&log, &builder), "2.50 1e-300\n");
+#endif
+
+  // The data behind the pointer of a registered conversion is only referenced, which copying logs refuse
+  TEST_CHECK(TinyFormatRegister('V', TINY_ARG_POINTER, TestConvertIntPointer) == 0);
+  TEST_CHECK(TinyLogPrintf(&log, "%V\n", &value) == -1 && log.dropped == 1);
+  TEST_CHECK(TinyLogInit(&log, buf, sizeof(buf), TINY_LOG_POINTER_STRINGS, 0) == 0);
+  TEST_CHECK(TinyLogPrintf(&log, "%V %s\n", &value, "literal") == 0);
+  TEST_STRING(TestConsume(&log, &builder), "42 literal\n");
+
+  TinyBuilderFree(&builder);
+}
+
+/**********************************************************************************************************************/
+/** A full log drops records until the consumer releases space, records are consumed in order across the wraparound
+ **********************************************************************************************************************/
+static void TestRing(void)
+{
+  static unsigned long long int buf[32];
+  static const char text[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+  TinyBuilder builder, expected;
+  TinyLog log;
+  int records, i;
+
+  TinyBuilderInit(&builder, TestReallocate, NULL);
+  TinyBuilderInit(&expected, TestReallocate, NULL);
+  TEST_CHECK(TinyLogInit(&log, buf, sizeof(buf), TINY_LOG_COPY_STRINGS, sizeof(text)) == 0);
+
+  // Fill the log up, further records are dropped and counted
+  for(records = 0; TinyLogPrintf(&log, "%d,", records) == 0; records++) {
+    TinyBuilderPrintf(&expected, "%d,", records);
+  }
+  TEST_CHECK(records > 1 && log.dropped == 1);
+  TEST_CHECK(TinyLogPrintf(&log, "%d,", records) == -1 && log.dropped == 2);
+  TEST_STRING(TestConsume(&log, &builder), expected.string);
+  TEST_CHECK(TinyLogConsume(&log, TinyBuilderSpan, &builder, -1) == 0);
+
+  // Records of varying size wrap around the end of the buffer many times, consumed one at a time or all at once
+  TinyBuilderReset(&expected);
+  TinyBuilderReset(&builder);
+  for(i = 0; i < 5000; i++) {
+    const char *string = text + i % (sizeof(text) - 1);
+    if(TinyLogPrintf(&log, "%d:%s;", i, string) != 0) {
+      TEST_CHECK(TinyLogConsume(&log, TinyBuilderSpan, &builder, (i % 3 == 0) ? 1 : -1) >= 1);
+      --i;
+      continue;
+    }
+    TinyBuilderPrintf(&expected, "%d:%s;", i, string);
+    if(i % 7 == 0) {
+      TEST_CHECK(TinyLogConsume(&log, TinyBuilderSpan, &builder, 2) >= 1);
+    }
+  }
+  TinyLogConsume(&log, TinyBuilderSpan, &builder, -1);
+  TEST_CHECK(log.head == log.tail && log.head > 10 * sizeof(buf));
+  TEST_CHECK(builder.length == expected.length && strcmp(builder.string, expected.string) == 0);
+
+  TinyBuilderFree(&builder);
+  TinyBuilderFree(&expected);
+}
+
+/**********************************************************************************************************************/
+/** Producer thread of TestThreads(), logs numbered records retrying while the log is full
+ **********************************************************************************************************************/
+static void *TestProducer(
+  /// [in] Deferred log
+  void *arg)
+{
+  TinyLog *log = arg;
+  int i;
+
+  for(i = 0; i < TEST_THREAD_RECORDS; i++) {
+    while(TinyLogPrintf(log, "%d %s\n", i, (i & 1) ? "odd" : "even") != 0) {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/**********************************************************************************************************************/
+/** Check that consumed records arrive complete and in order
+ **********************************************************************************************************************/
+static void TestCheckSequence(
+  /// [in,out] Number of the next record expected
+  void *ctx,
+  /// [in] Characters of one record (each record is printed as a number, a literal run, a string and a newline)
+  const char *string,
+  /// [in] Number of characters
+  size_t length)
+{
+  static char line[32];
+  static size_t used;
+  int *next = ctx;
+
+  if(used + length >= sizeof(line)) {
+    testFailures++;
+    used = 0;
+    return;
+  }
+  memcpy(line + used, string, length);
+  used += length;
+  if(line[used - 1] == '\n') {
+    char expected[32];
+    line[used] = '\0';
+    TinySNprintf(expected, sizeof(expected), "%d %s\n", *next, (*next & 1) ? "odd" : "even");
+    TEST_STRING(line, expected);
+    ++*next;
+    used = 0;
+  }
+}
+
+/**********************************************************************************************************************/
+/** One producer and one consumer thread share a log
+ **********************************************************************************************************************/
+static void TestThreads(void)
+{
+  static unsigned long long int buf[128];
+  pthread_t producer;
+  TinyLog log;
+  int next = 0;
+
+  TEST_CHECK(TinyLogInit(&log, buf, sizeof(buf), TINY_LOG_COPY_STRINGS, 8) == 0);
+  TEST_CHECK(pthread_create(&producer, NULL, TestProducer, &log) == 0);
+  while(next < TEST_THREAD_RECORDS) {
+    if(TinyLogConsume(&log, TestCheckSequence, &next, 16) == 0) {
+      sched_yield();
+    }
+  }
+  pthread_join(producer, NULL);
+  TEST_CHECK(next == TEST_THREAD_RECORDS && TinyLogConsume(&log, TestCheckSequence, &next, -1) == 0);
+}
+
+int main(void)
+{
+  TestArguments();
+  TestRing();
+  TestThreads();
+
+  TEST_RESULT();
+}
@@ -0,0 +1,342 @@
+/**********************************************************************************************************************/
+/** Buffered file descriptor output for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * A TinyStream must only be used by one thread at a time, TinyDprintf() keeps a separate buffer for every thread.
+ *
+ * @file tiny_dprintf.c
+ *
+ **********************************************************************************************************************/
+
+#include "tiny_dprintf.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/// Size of the per thread buffer of TinyDprintf()
+#ifndef TINY_DPRINTF_BUFFER
+#define TINY_DPRINTF_BUFFER 512
+#endif
+// The flush policy of TinyDprintf() is TINY_STREAM_LINE for terminals and TINY_STREAM_FULL for anything else, unless
+// TINY_DPRINTF_POLICY is defined
+/// Storage class for per thread data
+#ifndef TINY_PRINTF_THREAD_LOCAL
+#define TINY_PRINTF_THREAD_LOCAL _Thread_local
+#endif
+
+/**********************************************************************************************************************/
+/** Write the buffer and optionally one more span with a single system call
+ ***********************************************************************************************************************
+ *
+ * Partial writes are continued, the buffer is empty afterwards. If writing fails, the data is dropped and the error
+ * is remembered in the stream.
+ *
+ **********************************************************************************************************************/
+static void TinyStreamWrite(
+  /// [in,out] Stream
+  TinyStream *stream,
+  /// [in] Span written after the buffer contents (NULL for none)
+  const char *string,
+  /// [in] Length of the span
+  size_t length)
+{
+  struct iovec iov[2];
+  int count = 0;
+
+  if(stream->used != 0) {
+    iov[count].iov_base = stream->buf;
+    iov[count].iov_len = stream->used;
+    count++;
+  }
+  if(length != 0) {
+    iov[count].iov_base = (void *)string;
+    iov[count].iov_len = length;
+    count++;
+  }
+  stream->used = 0;
+  stream->newline = 0;
+
+  while(count != 0) {
+    ssize_t written = writev(stream->fd, iov, count);
+    if(written <= 0) {
+      if(written < 0 && errno == EINTR) {
+        continue;
+      }
+      // Writing nothing would never make progress, report it as I/O error
+      if(stream->error == 0) {
+        stream->error = (written < 0) ? errno : EIO;
+      }
+      return;
+    }
+    // Skip what has been written
+    while(count != 0 && (size_t)written >= iov[0].iov_len) {
+      written -= iov[0].iov_len;
+      iov[0] = iov[1];
+      count--;
+    }
+    if(count != 0) {
+      iov[0].iov_base = (char *)iov[0].iov_base + written;
+      iov[0].iov_len -= written;
+    }
+  }
+}
+
+/**********************************************************************************************************************/
+/** Put a span of bytes into the stream
+ **********************************************************************************************************************/
+static void TinyStreamPrintSpan(
+  /// [in] Pointer to the stream
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  // This will spare us a lots of casts.
+  TinyStream *stream = context;
+
+  if(stream->policy == TINY_STREAM_LINE && !stream->newline && memchr(string, '\n', length) != NULL) {
+    stream->newline = 1;
+  }
+
+  if(length <= stream->size - stream->used) {
+    memcpy(stream->buf + stream->used, string, length);
+    stream->used += length;
+  }
+  else {
+    // Does not fit, write the buffer together with the span without copying it
+    TinyStreamWrite(stream, string, length);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Initialize a buffered stream
+ **********************************************************************************************************************/
+void TinyStreamInit(
+  /// [out] Stream
+  TinyStream *stream,
+  /// [in] File descriptor to write to
+  int fd,
+  /// [in] Buffer
+  char *buf,
+  /// [in] Size of the buffer
+  size_t size,
+  /// [in] Flush policy
+  TinyStreamPolicy policy)
+{
+  stream->fd = fd;
+  stream->policy = policy;
+  stream->buf = buf;
+  stream->size = size;
+  stream->used = 0;
+  stream->newline = 0;
+  stream->error = 0;
+}
+
+/**********************************************************************************************************************/
+/** Write the buffered output
+ ***********************************************************************************************************************
+ *
+ * @returns 0 or -1 if any write of the stream failed (errno is set)
+ *
+ **********************************************************************************************************************/
+int TinyStreamFlush(
+  /// [in,out] Stream
+  TinyStream *stream)
+{
+  if(stream->used != 0) {
+    TinyStreamWrite(stream, NULL, 0);
+  }
+  if(stream->error != 0) {
+    errno = stream->error;
+    return -1;
+  }
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** printf into a buffered stream
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed or -1 if any write of the stream failed (errno is set)
+ *
+ **********************************************************************************************************************/
+int TinyStreamVPrintf(
+  /// [in,out] Stream
+  TinyStream *stream,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  va_list args)
+{
+  int ret = TinyPrintfSpan(TinyStreamPrintSpan, stream, fmt, args);
+
+  if(stream->policy == TINY_STREAM_CALL || stream->newline) {
+    TinyStreamWrite(stream, NULL, 0);
+  }
+  if(stream->error != 0) {
+    errno = stream->error;
+    return -1;
+  }
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** printf into a buffered stream
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed or -1 if any write of the stream failed (errno is set)
+ *
+ **********************************************************************************************************************/
+int TinyStreamPrintf(
+  /// [in,out] Stream
+  TinyStream *stream,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int ret;
+
+  va_start(va, fmt);
+  ret = TinyStreamVPrintf(stream, fmt, va);
+  va_end(va);
+
+  return ret;
+}
+
+/// Per thread stream of TinyDprintf()
+static TINY_PRINTF_THREAD_LOCAL TinyStream tinyDprintfStream;
+/// Per thread buffer of TinyDprintf()
+static TINY_PRINTF_THREAD_LOCAL char tinyDprintfBuffer[TINY_DPRINTF_BUFFER];
+/// Key whose destructor flushes the stream of an exiting thread
+static pthread_key_t tinyDprintfKey;
+/// Creates tinyDprintfKey once
+static pthread_once_t tinyDprintfOnce = PTHREAD_ONCE_INIT;
+
+/**********************************************************************************************************************/
+/** Write what is left in the stream of an exiting thread
+ **********************************************************************************************************************/
+static void TinyDprintfThreadExit(
+  /// [in] Stream of the thread
+  void *stream)
+{
+  TinyStreamFlush(stream);
+}
+
+/**********************************************************************************************************************/
+/** Write what is left in the stream of the thread calling exit()
+ **********************************************************************************************************************/
+static void TinyDprintfExit(void)
+{
+  TinyDprintfFlush();
+}
+
+/**********************************************************************************************************************/
+/** Set up flushing at thread and process exit, once per process
+ **********************************************************************************************************************/
+static void TinyDprintfSetup(void)
+{
+  pthread_key_create(&tinyDprintfKey, TinyDprintfThreadExit);
+  atexit(TinyDprintfExit);
+}
+
+/**********************************************************************************************************************/
+/** printf to a file descriptor
+ ***********************************************************************************************************************
+ *
+ * Output is collected in a per thread buffer and written according to TINY_DPRINTF_POLICY (by default at the end of
+ * lines for terminals, when the buffer is full otherwise). Output still in the buffer is written when printing to a
+ * different file descriptor, by TinyDprintfFlush(), when the thread exits and when the process calls exit() (for the
+ * calling thread). _exit() and abnormal termination lose it.
+ *
+ * @returns number of bytes printed or -1 if writing failed (errno is set)
+ *
+ **********************************************************************************************************************/
+int TinyDprintf(
+  /// [in] File descriptor
+  int fd,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  ...)
+{
+  TinyStream *stream = &tinyDprintfStream;
+  va_list va;
+  int ret;
+
+  if(stream->buf == NULL || stream->fd != fd) {
+    TinyStreamPolicy policy;
+    if(stream->buf != NULL) {
+      TinyStreamFlush(stream);
+    }
+    else {
+      // First use in this thread, the key only runs its destructor for threads that set a value
+      pthread_once(&tinyDprintfOnce, TinyDprintfSetup);
+      pthread_setspecific(tinyDprintfKey, stream);
+    }
+#ifdef TINY_DPRINTF_POLICY
+    policy = TINY_DPRINTF_POLICY;
+#else
+    // Line buffered for terminals, fully buffered otherwise, like stdio
+    policy = isatty(fd) ? TINY_STREAM_LINE : TINY_STREAM_FULL;
+#endif
+    TinyStreamInit(stream, fd, tinyDprintfBuffer, sizeof(tinyDprintfBuffer), policy);
+  }
+
+  va_start(va, fmt);
+  ret = TinyStreamVPrintf(stream, fmt, va);
+  va_end(va);
+
+  // Errors are reported once
+  stream->error = 0;
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Write the output TinyDprintf() buffered for the calling thread
+ ***********************************************************************************************************************
+ *
+ * @returns 0 or -1 if writing failed (errno is set)
+ *
+ **********************************************************************************************************************/
+int TinyDprintfFlush(void)
+{
+  TinyStream *stream = &tinyDprintfStream;
+  int ret;
+
+  if(stream->buf == NULL) {
+    return 0;
+  }
+
+  ret = TinyStreamFlush(stream);
+  stream->error = 0;
+
+  return ret;
+}
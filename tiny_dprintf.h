@@ -0,0 +1,77 @@
+/**********************************************************************************************************************/
+/** Buffered file descriptor output for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * A TinyStream must only be used by one thread at a time, TinyDprintf() keeps a separate buffer for every thread.
+ *
+ * @file tiny_dprintf.h
+ *
+ **********************************************************************************************************************/
+
+#ifndef TINY_DPRINTF_H_
+#define TINY_DPRINTF_H_
+
+#include "tiny_printf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Flush policies of a buffered stream
+typedef enum {
+  /// Write only when the buffer is full or TinyStreamFlush() is called
+  TINY_STREAM_FULL,
+  /// Additionally write at the end of every printf call that printed a newline
+  TINY_STREAM_LINE,
+  /// Write at the end of every printf call
+  TINY_STREAM_CALL
+} TinyStreamPolicy;
+
+/// Buffered file descriptor stream
+typedef struct {
+  /// File descriptor to write to
+  int fd;
+  /// Flush policy
+  TinyStreamPolicy policy;
+  /// Buffer
+  char *buf;
+  /// Size of the buffer
+  size_t size;
+  /// Number of bytes in the buffer
+  size_t used;
+  /// A newline was printed since the last flush
+  int newline;
+  /// errno of the first failed write, 0 if none failed
+  int error;
+} TinyStream;
+
+void TinyStreamInit(TinyStream *stream, int fd, char *buf, size_t size, TinyStreamPolicy policy);
+int TinyStreamVPrintf(TinyStream *stream, const char *fmt, va_list args);
+int TinyStreamPrintf(TinyStream *stream, const char *fmt, ...);
+int TinyStreamFlush(TinyStream *stream);
+int TinyDprintf(int fd, const char *fmt, ...);
+int TinyDprintfFlush(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //TINY_DPRINTF_H_
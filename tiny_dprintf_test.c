@@ -0,0 +1,202 @@
+/**********************************************************************************************************************/
+/** Tiny printf buffered file descriptor output tests
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Hosted checks of TinyStream and TinyDprintf() on pipes, build and run them with:
+ * cc -pthread tiny_printf.c tiny_dprintf.c tiny_dprintf_test.c -o tiny_dprintf_test
+ * ./tiny_dprintf_test
+ *
+ * @file tiny_dprintf_test.c
+ *
+ **********************************************************************************************************************/
+
+// pipe(), fork() and fcntl() are POSIX, strict ISO C builds only declare them with a feature test macro
+#if !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "tiny_dprintf.h"
+#include "tiny_test.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**********************************************************************************************************************/
+/** Read what is in a non-blocking pipe
+ ***********************************************************************************************************************
+ *
+ * @returns the bytes read as null terminated string (static, overwritten by the next call)
+ *
+ **********************************************************************************************************************/
+static const char *TestRead(
+  /// [in] Read end of the pipe
+  int fd)
+{
+  static char string[4096];
+  ssize_t got;
+  size_t length = 0;
+
+  while(length < sizeof(string) - 1 && (got = read(fd, string + length, sizeof(string) - 1 - length)) > 0) {
+    length += got;
+  }
+  string[length] = '\0';
+
+  return string;
+}
+
+/**********************************************************************************************************************/
+/** Create a pipe with a non-blocking read end
+ ***********************************************************************************************************************
+ *
+ * @returns 0 or -1 if creating the pipe failed
+ *
+ **********************************************************************************************************************/
+static int TestPipe(
+  /// [out] Read and write end
+  int fds[2])
+{
+  if(pipe(fds) != 0) {
+    return -1;
+  }
+
+  return fcntl(fds[0], F_SETFL, O_NONBLOCK);
+}
+
+/**********************************************************************************************************************/
+/** Streams write according to their policy
+ **********************************************************************************************************************/
+static void TestStream(void)
+{
+  static char large[300];
+  char buf[64];
+  TinyStream stream;
+  int fds[2];
+
+  if(TestPipe(fds) != 0) {
+    TEST_CHECK(!"pipe");
+    return;
+  }
+
+  // Full: only when the buffer is full or flushed
+  TinyStreamInit(&stream, fds[1], buf, sizeof(buf), TINY_STREAM_FULL);
+  TEST_CHECK(TinyStreamPrintf(&stream, "line %d\n", 1) == 7);
+  TEST_STRING(TestRead(fds[0]), "");
+  TEST_CHECK(TinyStreamFlush(&stream) == 0);
+  TEST_STRING(TestRead(fds[0]), "line 1\n");
+
+  // A span not fitting is written together with the buffer, nothing is lost or reordered
+  memset(large, 'x', sizeof(large) - 1);
+  TEST_CHECK(TinyStreamPrintf(&stream, "<%s>", large) == (int)sizeof(large) + 1);
+  TEST_CHECK(strlen(TestRead(fds[0])) == sizeof(large) - 1 + 1);
+  TEST_CHECK(TinyStreamFlush(&stream) == 0);
+  TEST_STRING(TestRead(fds[0]), ">");
+
+  // Line: at the end of calls that printed a newline
+  TinyStreamInit(&stream, fds[1], buf, sizeof(buf), TINY_STREAM_LINE);
+  TEST_CHECK(TinyStreamPrintf(&stream, "no newline") == 10);
+  TEST_STRING(TestRead(fds[0]), "");
+  TEST_CHECK(TinyStreamPrintf(&stream, ", newline %s\n", "here") == 15);
+  TEST_STRING(TestRead(fds[0]), "no newline, newline here\n");
+
+  // Call: at the end of every call
+  TinyStreamInit(&stream, fds[1], buf, sizeof(buf), TINY_STREAM_CALL);
+  TEST_CHECK(TinyStreamPrintf(&stream, "%c", 'c') == 1);
+  TEST_STRING(TestRead(fds[0]), "c");
+
+  // Failed writes are reported with errno
+  close(fds[0]);
+  close(fds[1]);
+  TinyStreamInit(&stream, fds[1], buf, sizeof(buf), TINY_STREAM_FULL);
+  TEST_CHECK(TinyStreamPrintf(&stream, "lost") == 4);
+  errno = 0;
+  TEST_CHECK(TinyStreamFlush(&stream) == -1 && errno == EBADF);
+}
+
+/**********************************************************************************************************************/
+/** Thread printing without flushing
+ **********************************************************************************************************************/
+static void *TestThread(
+  /// [in] Pointer to the write end of a pipe
+  void *arg)
+{
+  TinyDprintf(*(int *)arg, "from thread %d\n", 7);
+
+  return NULL;
+}
+
+/**********************************************************************************************************************/
+/** TinyDprintf() buffers fully for pipes and flushes when switching descriptors, at thread exit and at exit()
+ **********************************************************************************************************************/
+static void TestDprintf(void)
+{
+  pthread_t thread;
+  pid_t child;
+  int fds[2], other[2], status;
+
+  if(TestPipe(fds) != 0 || TestPipe(other) != 0) {
+    TEST_CHECK(!"pipe");
+    return;
+  }
+
+  // A pipe is no terminal, so even lines stay buffered
+  TEST_CHECK(TinyDprintf(fds[1], "first %s\n", "line") == 11);
+  TEST_STRING(TestRead(fds[0]), "");
+  TEST_CHECK(TinyDprintf(other[1], "other\n") == 6);
+  TEST_STRING(TestRead(fds[0]), "first line\n");
+  TEST_CHECK(TinyDprintfFlush() == 0);
+  TEST_STRING(TestRead(other[0]), "other\n");
+
+  TEST_CHECK(pthread_create(&thread, NULL, TestThread, &fds[1]) == 0);
+  pthread_join(thread, NULL);
+  TEST_STRING(TestRead(fds[0]), "from thread 7\n");
+
+  // The child must not print the failures reported so far again
+  fflush(stdout);
+  child = fork();
+  if(child == 0) {
+    TinyDprintf(fds[1], "from child\n");
+    exit(0);
+  }
+  TEST_CHECK(child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status));
+  TEST_STRING(TestRead(fds[0]), "from child\n");
+
+  // Write errors are reported once
+  close(other[0]);
+  close(other[1]);
+  TEST_CHECK(TinyDprintf(other[1], "lost") == 4);
+  TEST_CHECK(TinyDprintfFlush() == -1 && errno == EBADF);
+  TEST_CHECK(TinyDprintfFlush() == 0);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int main(void)
+{
+  TestStream();
+  TestDprintf();
+
+  TEST_RESULT();
+}
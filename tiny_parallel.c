@@ -0,0 +1,614 @@
+/**********************************************************************************************************************/
+/** Parallel batch formatting for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The records of a batch are split into blocks formatted by a pool of threads, each block into a chunk buffer of its
+ * own. Threads running out of blocks steal from the end of the ranges of the others. The chunks are handed to the
+ * output in record order, so the result is the same as of TinyFormatBatch() on one thread.
+ *
+ * @file tiny_parallel.c
+ *
+ **********************************************************************************************************************/
+
+#include "tiny_parallel.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Default number of records per block
+#ifndef TINY_PARALLEL_BLOCK
+#define TINY_PARALLEL_BLOCK 1024
+#endif
+/// Blocks per thread and window, two windows of chunks are allocated
+#ifndef TINY_PARALLEL_WINDOW
+#define TINY_PARALLEL_WINDOW 8
+#endif
+/// Initial size of a chunk buffer, chunks grow when a block does not fit
+#ifndef TINY_PARALLEL_CHUNK
+#define TINY_PARALLEL_CHUNK 65536
+#endif
+/// Size of a cache line
+#ifndef TINY_PARALLEL_CACHE_LINE
+#define TINY_PARALLEL_CACHE_LINE 64
+#endif
+
+/// Blocks left to a thread
+typedef struct {
+  /// Next block in the low, end of the range in the high 32 bits, changed together with compare and swap
+  unsigned long long int range;
+  /// Keep the ranges of different threads in different cache lines
+  char pad[TINY_PARALLEL_CACHE_LINE - sizeof(unsigned long long int)];
+} TinyParallelQueue;
+
+/// Formatted output of one block
+typedef struct {
+  /// Buffer
+  char *buf;
+  /// Size of the buffer
+  size_t size;
+  /// Number of bytes formatted
+  size_t used;
+} TinyParallelChunk;
+
+/// State shared by the threads of a job
+typedef struct {
+  /// Job
+  const TinyParallelJob *job;
+  /// Number of threads
+  int threads;
+  /// Records per block
+  int blockRecords;
+  /// First record of the current window
+  size_t first;
+  /// Blocks left, one range per thread
+  TinyParallelQueue *queues;
+  /// Output of the blocks of the current window
+  TinyParallelChunk *chunks;
+  /// Protects the members below
+  pthread_mutex_t lock;
+  /// Signalled when a window is started or the job is finished
+  pthread_cond_t start;
+  /// Signalled when the last worker thread finished a window
+  pthread_cond_t done;
+  /// Incremented for every window
+  unsigned int generation;
+  /// Number of worker threads still formatting the current window
+  int running;
+  /// Set when the worker threads have to exit
+  int stop;
+  /// Set when a chunk could not be allocated
+  int error;
+} TinyParallelPool;
+
+/// One thread of a job
+typedef struct {
+  /// Shared state
+  TinyParallelPool *pool;
+  /// Index of the thread, the calling thread is 0
+  int index;
+  /// Row offsets of TinyFormatBatch()
+  size_t *offsets;
+  /// Thread handle (not used for the calling thread)
+  pthread_t thread;
+} TinyParallelWorker;
+
+/**********************************************************************************************************************/
+/** Take a block from a range
+ ***********************************************************************************************************************
+ *
+ * The owner takes blocks from the front, other threads steal from the back.
+ *
+ * @returns block index or -1 if the range is empty
+ *
+ **********************************************************************************************************************/
+static long TinyParallelTake(
+  /// [in,out] Range of blocks
+  TinyParallelQueue *queue,
+  /// [in] Take from the back
+  int back)
+{
+  unsigned long long int range = __atomic_load_n(&queue->range, __ATOMIC_RELAXED), next;
+
+  do {
+    if((range & 0xFFFFFFFFu) >= (range >> 32)) {
+      return -1;
+    }
+    next = back ? range - (1ull << 32) : range + 1;
+    // The chunks are published to the output by the pool lock, so the ranges need no ordering
+  } while(!__atomic_compare_exchange_n(&queue->range, &range, next, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  return back ? (long)(next >> 32) : (long)(range & 0xFFFFFFFFu);
+}
+
+/**********************************************************************************************************************/
+/** Format one block into its chunk
+ ***********************************************************************************************************************
+ *
+ * @returns 0 on success, -1 if the chunk could not be grown
+ *
+ **********************************************************************************************************************/
+static int TinyParallelFormat(
+  /// [in] Thread
+  TinyParallelWorker *worker,
+  /// [in] Block of the current window
+  long block)
+{
+  TinyParallelPool *pool = worker->pool;
+  const TinyParallelJob *job = pool->job;
+  TinyParallelChunk *chunk = &pool->chunks[block];
+  size_t first = pool->first + (size_t)block * pool->blockRecords;
+  size_t count = job->count - first;
+  const unsigned char *records = (const unsigned char *)job->records + first * job->stride;
+
+  if(count > (size_t)pool->blockRecords) {
+    count = pool->blockRecords;
+  }
+  chunk->used = 0;
+  for(;;) {
+    int rows = TinyFormatBatch(job->compiled, job->fields, records, job->stride, (int)count,
+                               chunk->buf + chunk->used, chunk->size - chunk->used, worker->offsets);
+    char *buf;
+    chunk->used += worker->offsets[rows];
+    records += rows * job->stride;
+    count -= rows;
+    if(count == 0) {
+      return 0;
+    }
+    // Called on the worker thread, the allocator must be thread safe
+    buf = job->reallocate(job->allocCtx, chunk->buf, chunk->size * 2);
+    if(buf == NULL) {
+      return -1;
+    }
+    chunk->buf = buf;
+    chunk->size *= 2;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Format blocks of the current window until none are left
+ ***********************************************************************************************************************
+ *
+ * @returns 0 on success, -1 if a chunk could not be grown
+ *
+ **********************************************************************************************************************/
+static int TinyParallelWork(
+  /// [in] Thread
+  TinyParallelWorker *worker)
+{
+  TinyParallelPool *pool = worker->pool;
+  int error = 0;
+
+  for(;;) {
+    long block = TinyParallelTake(&pool->queues[worker->index], 0);
+    int i;
+    // Steal from the other threads, starting with the next one so thieves spread out
+    for(i = 1; block < 0 && i < pool->threads; i++) {
+      block = TinyParallelTake(&pool->queues[(worker->index + i) % pool->threads], 1);
+    }
+    if(block < 0) {
+      return error;
+    }
+    if(error == 0) {
+      error = TinyParallelFormat(worker, block);
+    }
+  }
+}
+
+/**********************************************************************************************************************/
+/** Worker thread
+ **********************************************************************************************************************/
+static void *TinyParallelThread(
+  /// [in] Thread
+  void *arg)
+{
+  TinyParallelWorker *worker = arg;
+  TinyParallelPool *pool = worker->pool;
+  unsigned int generation = 0;
+
+  for(;;) {
+    int error;
+    pthread_mutex_lock(&pool->lock);
+    while(pool->generation == generation && !pool->stop) {
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    if(pool->stop) {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
+    }
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    error = TinyParallelWork(worker);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->error |= error;
+    if(--pool->running == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Start formatting the current window with the worker threads
+ ***********************************************************************************************************************
+ *
+ * Every thread starts with an equal share of consecutive blocks.
+ *
+ **********************************************************************************************************************/
+static void TinyParallelStart(
+  /// [in,out] Shared state
+  TinyParallelPool *pool,
+  /// [in] Number of blocks of the window
+  long blocks)
+{
+  int i;
+
+  for(i = 0; i < pool->threads; i++) {
+    unsigned long long int begin = blocks * i / pool->threads, end = blocks * (i + 1) / pool->threads;
+    pool->queues[i].range = begin | (end << 32);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->generation++;
+  pool->running = pool->threads - 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**********************************************************************************************************************/
+/** Help formatting the current window and wait until it is done
+ ***********************************************************************************************************************
+ *
+ * @returns 0 on success, -1 if a chunk could not be grown
+ *
+ **********************************************************************************************************************/
+static int TinyParallelFinish(
+  /// [in] Calling thread
+  TinyParallelWorker *worker)
+{
+  TinyParallelPool *pool = worker->pool;
+  int error = TinyParallelWork(worker);
+
+  pthread_mutex_lock(&pool->lock);
+  while(pool->running != 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  error |= pool->error;
+  pthread_mutex_unlock(&pool->lock);
+
+  return error;
+}
+
+/**********************************************************************************************************************/
+/** Hand the chunks of a window to the output in order
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static long long int TinyParallelPrint(
+  /// [in] Chunks of the window
+  const TinyParallelChunk *chunks,
+  /// [in] Number of blocks of the window
+  long blocks,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx)
+{
+  long long int pc = 0;
+  long block;
+
+  for(block = 0; block < blocks; block++) {
+    printspan(ctx, chunks[block].buf, chunks[block].used);
+    pc += chunks[block].used;
+  }
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Release memory of a job, NULL is ignored
+ **********************************************************************************************************************/
+static void TinyParallelRelease(
+  /// [in] Job
+  const TinyParallelJob *job,
+  /// [in] Memory to release
+  void *memory)
+{
+  if(memory != NULL) {
+    job->reallocate(job->allocCtx, memory, 0);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Format an array of records with a pool of threads until the output asks to stop
+ ***********************************************************************************************************************
+ *
+ * See TinyParallelBatch(). The stop flag is read by the calling thread after handing a window to printspan, so
+ * printspan may set it without synchronization. At most the window formatted meanwhile is wasted.
+ *
+ * @returns number of bytes printed or -1 if memory could not be allocated
+ *
+ **********************************************************************************************************************/
+static long long int TinyParallelRun(
+  /// [in] Job
+  const TinyParallelJob *job,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx,
+  /// [in] Set by printspan when no more output is wanted
+  const int *stop)
+{
+  TinyParallelPool pool;
+  TinyParallelWorker *workers;
+  long long int pc = 0;
+  TinyParallelChunk *chunks;
+  long windowBlocks, block, window, previous = 0;
+  int threads, created, i;
+
+  threads = job->threads > 0 ? job->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads < 1) {
+    threads = 1;
+  }
+  windowBlocks = (long)threads * TINY_PARALLEL_WINDOW;
+  pool.job = job;
+  pool.threads = threads;
+  pool.blockRecords = (job->blockRecords > 0 && job->blockRecords < INT_MAX) ? job->blockRecords : TINY_PARALLEL_BLOCK;
+  pool.generation = 0;
+  pool.running = 0;
+  pool.stop = 0;
+  pool.error = 0;
+
+  // Allocate everything up front, the threads only grow chunks later
+  workers = job->reallocate(job->allocCtx, NULL, threads * sizeof(TinyParallelWorker));
+  pool.queues = job->reallocate(job->allocCtx, NULL, threads * sizeof(TinyParallelQueue));
+  chunks = job->reallocate(job->allocCtx, NULL, 2 * windowBlocks * sizeof(TinyParallelChunk));
+  if(workers == NULL || pool.queues == NULL || chunks == NULL) {
+    pool.error = -1;
+    threads = 0;
+    windowBlocks = 0;
+  }
+  for(block = 0; block < 2 * windowBlocks; block++) {
+    chunks[block].buf = job->reallocate(job->allocCtx, NULL, TINY_PARALLEL_CHUNK);
+    chunks[block].size = TINY_PARALLEL_CHUNK;
+    pool.error |= -(chunks[block].buf == NULL);
+  }
+  for(i = 0; i < threads; i++) {
+    workers[i].pool = &pool;
+    workers[i].index = i;
+    workers[i].offsets = job->reallocate(job->allocCtx, NULL, (pool.blockRecords + 1) * sizeof(size_t));
+    pool.error |= -(workers[i].offsets == NULL);
+  }
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.start, NULL);
+  pthread_cond_init(&pool.done, NULL);
+  // Go on with the threads that could be started
+  for(created = 1; pool.error == 0 && created < threads; created++) {
+    if(pthread_create(&workers[created].thread, NULL, TinyParallelThread, &workers[created]) != 0) {
+      break;
+    }
+  }
+  pool.threads = created;
+
+  // Two sets of chunks: the calling thread hands one window to the output while the others format the next one
+  for(window = 0, pool.first = 0; pool.error == 0 && !*stop && pool.first < job->count;
+      window++, pool.first += (size_t)windowBlocks * pool.blockRecords) {
+    size_t records = job->count - pool.first;
+    long blocks = windowBlocks;
+    if(records < (size_t)windowBlocks * pool.blockRecords) {
+      blocks = (long)((records + pool.blockRecords - 1) / pool.blockRecords);
+    }
+    pool.chunks = chunks + (window & 1) * windowBlocks;
+    TinyParallelStart(&pool, blocks);
+    pc += TinyParallelPrint(chunks + (~window & 1) * windowBlocks, previous, printspan, ctx);
+    if(TinyParallelFinish(workers) != 0) {
+      pool.error = -1;
+    }
+    previous = blocks;
+  }
+  if(pool.error == 0 && !*stop) {
+    pc += TinyParallelPrint(chunks + (~window & 1) * windowBlocks, previous, printspan, ctx);
+  }
+
+  pthread_mutex_lock(&pool.lock);
+  pool.stop = 1;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.lock);
+  for(i = 1; i < created; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  pthread_cond_destroy(&pool.done);
+  pthread_cond_destroy(&pool.start);
+  pthread_mutex_destroy(&pool.lock);
+
+  for(block = 0; block < 2 * windowBlocks; block++) {
+    TinyParallelRelease(job, chunks[block].buf);
+  }
+  for(i = 0; i < threads; i++) {
+    TinyParallelRelease(job, workers[i].offsets);
+  }
+  TinyParallelRelease(job, chunks);
+  TinyParallelRelease(job, pool.queues);
+  TinyParallelRelease(job, workers);
+
+  return pool.error ? -1 : pc;
+}
+
+/**********************************************************************************************************************/
+/** Format an array of records with a pool of threads
+ ***********************************************************************************************************************
+ *
+ * The records are formatted window by window: the blocks of a window are formatted in parallel, then their chunks
+ * are handed to printspan in record order, one call per block, while the next window is formatted. The calling thread
+ * makes all printspan calls and takes part in the formatting in between.
+ *
+ * @returns number of bytes printed or -1 if memory could not be allocated
+ *
+ **********************************************************************************************************************/
+long long int TinyParallelBatch(
+  /// [in] Job
+  const TinyParallelJob *job,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx)
+{
+  static const int never = 0;
+
+  return TinyParallelRun(job, printspan, ctx, &never);
+}
+
+/// Output buffer of TinyParallelBatchBuffer()
+typedef struct {
+  /// Next free character
+  char *string;
+  /// Space left
+  size_t length;
+  /// Set if a chunk did not fit
+  int overflow;
+} TinyParallelBuffer;
+
+/**********************************************************************************************************************/
+/** Put a chunk into the output buffer
+ **********************************************************************************************************************/
+static void TinyParallelBufferSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  TinyParallelBuffer *ctx = context;
+
+  if(length > ctx->length) {
+    ctx->overflow = 1;
+    length = ctx->length;
+  }
+  memcpy(ctx->string, string, length);
+  ctx->string += length;
+  ctx->length -= length;
+}
+
+/**********************************************************************************************************************/
+/** Format an array of records with a pool of threads into a buffer
+ ***********************************************************************************************************************
+ *
+ * The output is not null terminated. Formatting stops with the first window not fitting.
+ *
+ * @returns number of bytes written or -1 if the output does not fit or memory could not be allocated
+ *
+ **********************************************************************************************************************/
+long long int TinyParallelBatchBuffer(
+  /// [in] Job
+  const TinyParallelJob *job,
+  /// [out] Output buffer
+  char *buf,
+  /// [in] Size of the output buffer
+  size_t size)
+{
+  TinyParallelBuffer ctx;
+  long long int pc;
+
+  ctx.string = buf;
+  ctx.length = size;
+  ctx.overflow = 0;
+  pc = TinyParallelRun(job, TinyParallelBufferSpan, &ctx, &ctx.overflow);
+
+  return ctx.overflow ? -1 : pc;
+}
+
+/// Output file descriptor of TinyParallelBatchFd()
+typedef struct {
+  /// File descriptor to write to
+  int fd;
+  /// errno of the first failed write, 0 if none failed
+  int error;
+} TinyParallelFd;
+
+/**********************************************************************************************************************/
+/** Write a chunk to the output file descriptor
+ ***********************************************************************************************************************
+ *
+ * Partial writes are continued, after an error (a write of nothing counts as EIO) nothing more is written.
+ *
+ **********************************************************************************************************************/
+static void TinyParallelFdSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  TinyParallelFd *ctx = context;
+
+  while(length != 0 && ctx->error == 0) {
+    ssize_t written = write(ctx->fd, string, length);
+    if(written <= 0) {
+      if(written < 0 && errno == EINTR) {
+        continue;
+      }
+      // Writing nothing would never make progress, report it as I/O error
+      ctx->error = (written < 0) ? errno : EIO;
+      return;
+    }
+    string += written;
+    length -= written;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Format an array of records with a pool of threads and write them to a file descriptor
+ ***********************************************************************************************************************
+ *
+ * Every chunk is written with one write() call while the other threads go on with the next window. Formatting stops
+ * with the first failed write.
+ *
+ * @returns number of bytes written or -1 if writing failed (errno is set) or memory could not be allocated
+ *
+ **********************************************************************************************************************/
+long long int TinyParallelBatchFd(
+  /// [in] Job
+  const TinyParallelJob *job,
+  /// [in] File descriptor to write to
+  int fd)
+{
+  TinyParallelFd ctx;
+  long long int pc;
+
+  ctx.fd = fd;
+  ctx.error = 0;
+  pc = TinyParallelRun(job, TinyParallelFdSpan, &ctx, &ctx.error);
+  if(ctx.error != 0) {
+    errno = ctx.error;
+    return -1;
+  }
+
+  return pc;
+}
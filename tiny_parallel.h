@@ -0,0 +1,71 @@
+/**********************************************************************************************************************/
+/** Parallel batch formatting for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The records of a batch are split into blocks formatted by a pool of threads, each block into a chunk buffer of its
+ * own. Threads running out of blocks steal from the end of the ranges of the others. The chunks are handed to the
+ * output in record order, so the result is the same as of TinyFormatBatch() on one thread.
+ *
+ * @file tiny_parallel.h
+ *
+ **********************************************************************************************************************/
+
+#ifndef TINY_PARALLEL_H_
+#define TINY_PARALLEL_H_
+
+#include "tiny_printf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Parallel batch formatting job
+typedef struct {
+  /// Compiled format applied to every record
+  const TinyFormat *compiled;
+  /// Record fields, in the order they are consumed (see TinyFormatBatch())
+  const TinyFormatField *fields;
+  /// Records
+  const void *records;
+  /// Distance between records in bytes (sizeof() of the record)
+  size_t stride;
+  /// Number of records
+  size_t count;
+  /// Number of threads including the calling one, 0 for one per online processor
+  int threads;
+  /// Records per block, 0 for TINY_PARALLEL_BLOCK
+  int blockRecords;
+  /// Allocator of the chunk buffers, they are released with reallocate(allocCtx, buffer, 0). Full chunks are grown by
+  /// the worker threads, so it is called concurrently and must be thread safe (as realloc() is).
+  reallocate_t reallocate;
+  /// Context of the allocator
+  void *allocCtx;
+} TinyParallelJob;
+
+long long int TinyParallelBatch(const TinyParallelJob *job, printspan_t printspan, void *ctx);
+long long int TinyParallelBatchBuffer(const TinyParallelJob *job, char *buf, size_t size);
+long long int TinyParallelBatchFd(const TinyParallelJob *job, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //TINY_PARALLEL_H_
@@ -0,0 +1,218 @@
+/**********************************************************************************************************************/
+/** Tiny printf parallel batch formatting tests
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Hosted checks of the parallel batch formatting against TinyFormatBatch(), build and run them with:
+ * cc -pthread tiny_printf.c tiny_parallel.c tiny_parallel_test.c -o tiny_parallel_test
+ * ./tiny_parallel_test
+ *
+ * @file tiny_parallel_test.c
+ *
+ **********************************************************************************************************************/
+
+#include "tiny_parallel.h"
+#include "tiny_test.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/// Number of records of the tests
+#define TEST_RECORDS 5000
+/// Record with the long name, its row does not fit into an initial chunk
+#define TEST_LONG_RECORD 2500
+/// Length of the long name, more than TINY_PARALLEL_CHUNK
+#define TEST_LONG_NAME 100000
+
+/// Record of the tests
+typedef struct {
+  /// Row number
+  int number;
+  /// Name (pointer)
+  const char *name;
+  /// Code, not null terminated
+  char code[4];
+} TestRecord;
+
+/// Number of times a buffer was grown by TestReallocate()
+static int testGrowths;
+
+/**********************************************************************************************************************/
+/** Reallocate with the C library, counting the growths (called concurrently by the worker threads)
+ **********************************************************************************************************************/
+static void *TestReallocate(
+  /// [in] Allocator context (unused)
+  void *ctx,
+  /// [in] Memory to resize, NULL to allocate
+  void *memory,
+  /// [in] New size, 0 to release
+  size_t size)
+{
+  (void)ctx;
+  if(size == 0) {
+    free(memory);
+    return NULL;
+  }
+  if(memory != NULL) {
+    __atomic_fetch_add(&testGrowths, 1, __ATOMIC_RELAXED);
+  }
+  return realloc(memory, size);
+}
+
+/**********************************************************************************************************************/
+/** Reallocate with the C library for TinyBuilder
+ **********************************************************************************************************************/
+static void *TestBuilderReallocate(
+  /// [in] Allocator context (unused)
+  void *ctx,
+  /// [in] Memory to resize, NULL to allocate
+  void *memory,
+  /// [in] New size, 0 to release
+  size_t size)
+{
+  (void)ctx;
+  if(size == 0) {
+    free(memory);
+    return NULL;
+  }
+  return realloc(memory, size);
+}
+
+/**********************************************************************************************************************/
+/** The output is the same as of TinyFormatBatch() for any number of threads and block size
+ **********************************************************************************************************************/
+static void TestCompare(
+  /// [in] Job, threads and blockRecords are varied
+  TinyParallelJob *job,
+  /// [in] Output of TinyFormatBatch()
+  const char *expected,
+  /// [in] Length of the output
+  size_t length)
+{
+  static const int threads[] = { 1, 2, 3, 8, 0 };
+  static const int blocks[] = { 0, 1, 7, 100, 10000 };
+  TinyBuilder builder;
+  size_t t, b;
+
+  TinyBuilderInit(&builder, TestBuilderReallocate, NULL);
+  for(t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+    for(b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+      job->threads = threads[t];
+      job->blockRecords = blocks[b];
+      TinyBuilderReset(&builder);
+      testGrowths = 0;
+      TEST_CHECK(TinyParallelBatch(job, TinyBuilderSpan, &builder) == (long long int)length);
+      TEST_CHECK(builder.length == length && memcmp(builder.string, expected, length) == 0);
+      // The block of the long record had to grow its chunk
+      TEST_CHECK(testGrowths > 0);
+    }
+  }
+  TinyBuilderFree(&builder);
+}
+
+/**********************************************************************************************************************/
+/** Output not fitting into the buffer or failing to write stops formatting early
+ **********************************************************************************************************************/
+static void TestStop(
+  /// [in] Job
+  TinyParallelJob *job,
+  /// [in] Output of TinyFormatBatch()
+  const char *expected,
+  /// [in] Length of the output
+  size_t length)
+{
+  char *buf = malloc(length);
+  char small[64];
+
+  if(buf == NULL) {
+    TEST_CHECK(!"malloc");
+    return;
+  }
+  job->threads = 2;
+  job->blockRecords = 1;
+
+  TEST_CHECK(TinyParallelBatchBuffer(job, buf, length) == (long long int)length);
+  TEST_CHECK(memcmp(buf, expected, length) == 0);
+  TEST_CHECK(TinyParallelBatchBuffer(job, buf, length - 1) == -1);
+
+  // The first windows do not fit, the long record far behind them is never formatted
+  testGrowths = 0;
+  TEST_CHECK(TinyParallelBatchBuffer(job, small, sizeof(small)) == -1);
+  TEST_CHECK(testGrowths == 0);
+  TEST_CHECK(memcmp(small, expected, sizeof(small)) == 0);
+
+  testGrowths = 0;
+  errno = 0;
+  TEST_CHECK(TinyParallelBatchFd(job, -1) == -1 && errno == EBADF);
+  TEST_CHECK(testGrowths == 0);
+
+  free(buf);
+}
+
+int main(void)
+{
+  static const char format[] = "%d;%-6s;%.4s;%x\n";
+  static const TinyFormatField fields[] = {
+    { offsetof(TestRecord, number), TINY_FIELD_INT },
+    { offsetof(TestRecord, name), TINY_FIELD_STRING },
+    { offsetof(TestRecord, code), TINY_FIELD_CHARS },
+    { offsetof(TestRecord, number), TINY_FIELD_INT }
+  };
+  static const char *const names[] = { "a", "bb", "cccccccc", "" };
+  static TestRecord records[TEST_RECORDS];
+  static size_t offsets[TEST_RECORDS + 1];
+  static char longName[TEST_LONG_NAME + 1];
+  TinyParallelJob job;
+  TinyFormatOp ops[8];
+  TinyFormat compiled;
+  size_t size = TEST_RECORDS * 32 + TEST_LONG_NAME;
+  char *expected = malloc(size);
+  int i;
+
+  if(expected == NULL) {
+    TEST_CHECK(!"malloc");
+    TEST_RESULT();
+  }
+  memset(longName, 'y', TEST_LONG_NAME);
+  for(i = 0; i < TEST_RECORDS; i++) {
+    records[i].number = i * 7919 - 1000000;
+    records[i].name = (i == TEST_LONG_RECORD) ? longName : names[i % 4];
+    memcpy(records[i].code, "WXYZ", 4);
+    records[i].code[i % 4] = (char)('0' + i % 10);
+  }
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 8, format) > 0);
+  TEST_CHECK(TinyFormatBatch(&compiled, fields, records, sizeof(records[0]), TEST_RECORDS, expected, size, offsets) ==
+             TEST_RECORDS);
+
+  job.compiled = &compiled;
+  job.fields = fields;
+  job.records = records;
+  job.stride = sizeof(records[0]);
+  job.count = TEST_RECORDS;
+  job.reallocate = TestReallocate;
+  job.allocCtx = NULL;
+
+  TestCompare(&job, expected, offsets[TEST_RECORDS]);
+  TestStop(&job, expected, offsets[TEST_RECORDS]);
+
+  free(expected);
+  TEST_RESULT();
+}
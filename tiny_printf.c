@@ -21,38 +21,145 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
- * All functions are thread safe.
+ * All functions are thread safe, except TinyFormatRegister(): registration must finish before formatting starts on
+ * other threads.
  *
  * @file tiny_printf.c
  *
  **********************************************************************************************************************/
 
+#if defined(TINY_PRINTF_TIMESTAMP) || (defined(TINY_PRINTF_STATS) && !defined(__x86_64__) && !defined(__i386__))
+// struct timespec and clock_gettime() are POSIX, strict ISO C builds only declare them with a feature test macro
+#if !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
 #include "tiny_printf.h"
+#include <limits.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#ifdef TINY_PRINTF_TIMESTAMP
+#include <time.h>
+#endif
 
 /***********************************************************************************************************************
- * Formatting options
+ * Formatting options (short names of the TINY_FORMAT_* bits)
  **********************************************************************************************************************/
-/// Pad to the right
-#define FORMAT_PAD_RIGHT  (1 << 0)
-/// Pad with zeros
-#define FORMAT_PAD_ZERO   (1 << 1)
-/// Format as long long
-#define FORMAT_LONG_LONG  (1 << 2)
+#define FORMAT_PAD_RIGHT  TINY_FORMAT_PAD_RIGHT
+#define FORMAT_PAD_ZERO   TINY_FORMAT_PAD_ZERO
+#define FORMAT_LONG_LONG  TINY_FORMAT_LONG_LONG
+#define FORMAT_PLUS       TINY_FORMAT_PLUS
+#define FORMAT_SPACE      TINY_FORMAT_SPACE
+#define FORMAT_ALT        TINY_FORMAT_ALT
+#define FORMAT_PRECISION  TINY_FORMAT_PRECISION
+
+#ifdef TINY_PRINTF_FLOAT
+/// Number of 32 bit limbs of the big integers used for exact floating point conversion (enough for double)
+#ifndef TINY_PRINTF_FLOAT_LIMBS
+#define TINY_PRINTF_FLOAT_LIMBS 40
+#endif
+#endif
+
+/// Number of conversions that can be registered with TinyFormatRegister()
+#ifndef TINY_PRINTF_CUSTOM_CONVERSIONS
+#define TINY_PRINTF_CUSTOM_CONVERSIONS 8
+#endif
+
+/// Size of the first allocation of a TinyBuilder
+#ifndef TINY_PRINTF_BUILDER_SIZE
+#define TINY_PRINTF_BUILDER_SIZE 256
+#endif
+
+#ifdef TINY_PRINTF_FORMAT_CACHE
+/// Maximum number of operations of a cached compiled format
+#ifndef TINY_PRINTF_FORMAT_CACHE_OPS
+#define TINY_PRINTF_FORMAT_CACHE_OPS 16
+#endif
+#endif
+
+#ifdef TINY_PRINTF_STATS
+#ifndef TINY_PRINTF_LONG_LONG
+#error "TINY_PRINTF_STATS needs TINY_PRINTF_LONG_LONG"
+#endif
+/// Number of counter sets the threads are spread over
+#ifndef TINY_PRINTF_STATS_SHARDS
+#define TINY_PRINTF_STATS_SHARDS 8
+#endif
+/// Clock of the statistics: TSC on x86, monotonic clock in nanoseconds elsewhere
+#ifndef TINY_PRINTF_STATS_CLOCK
+#if defined(__x86_64__) || defined(__i386__)
+#define TINY_PRINTF_STATS_CLOCK() __builtin_ia32_rdtsc()
+#else
+#include <time.h>
+#define TINY_PRINTF_STATS_CLOCK() TinyStatsMonotonic()
+#endif
+#endif
+#endif
+
+#if defined(TINY_PRINTF_FORMAT_CACHE) || defined(TINY_PRINTF_TIMESTAMP) || defined(TINY_PRINTF_STATS)
+/// Storage class for per thread data
+#ifndef TINY_PRINTF_THREAD_LOCAL
+#define TINY_PRINTF_THREAD_LOCAL _Thread_local
+#endif
+#endif
 
 /**********************************************************************************************************************/
-/** Print String
+/** Print a run of padding characters
  ***********************************************************************************************************************
  *
+ * The padding is handed to the printspan function in chunks instead of one character at a time.
+ *
  * @returns number of bytes printed
  *
  **********************************************************************************************************************/
-static int TinyPrintString(
-  /// [in] printchar function pointer
-  printchar_t printchar,
-  /// [in] context for printchar function
+static int TinyPrintPad(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
   void* ctx,
-  /// [in] String to print
+  /// [in] Padding character (' ' or '0')
+  int padchar,
+  /// [in] Number of padding characters to print
+  int count)
+{
+  static const char spaces[] = "                ";
+  static const char zeros[]  = "0000000000000000";
+  const char *pad = (padchar == '0') ? zeros : spaces;
+  int pc = 0;
+
+  while(count > 0) {
+    int chunk = (count < (int)sizeof(spaces) - 1) ? count : (int)sizeof(spaces) - 1;
+    printspan(ctx, pad, chunk);
+    pc += chunk;
+    count -= chunk;
+  }
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Print a character span padded to the desired width
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyPrintPadded(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Characters to print
   const char *string,
+  /// [in] Number of characters to print
+  int len,
   /// [in] Desired Width
   int width,
   /// [in] Formatting options
@@ -61,11 +168,6 @@ static int TinyPrintString(
   int pc = 0, padchar = ' ';
 
   if(width > 0) {
-    int len = 0;
-    const char *ptr;
-    for(ptr = string; *ptr; ++ptr) {
-      ++len;
-    }
     if(len >= width) {
       width = 0;
     }
@@ -78,24 +180,281 @@ static int TinyPrintString(
   }
 
   if(!(options & FORMAT_PAD_RIGHT)) {
-    for(; width > 0; --width) {
-      printchar(ctx, padchar);
-      ++pc;
-    }
+    pc += TinyPrintPad(printspan, ctx, padchar, width);
+    width = 0;
   }
 
-  for(; *string; ++string) {
-    printchar(ctx, *string);
-    ++pc;
+  if(len > 0) {
+    printspan(ctx, string, len);
+    pc += len;
   }
 
-  for(; width > 0; --width) {
-    printchar(ctx, padchar);
-    ++pc;
+  return pc + TinyPrintPad(printspan, ctx, padchar, width);
+}
+
+/**********************************************************************************************************************/
+/** Get the number of characters a string conversion prints
+ ***********************************************************************************************************************
+ *
+ * With a precision at most that many characters are read, so the string need not be terminated.
+ *
+ * @returns length of the string, limited to the precision
+ *
+ **********************************************************************************************************************/
+static int TinyStringLength(
+  /// [in] String
+  const char *string,
+  /// [in] Conversion (s)
+  const TinyFormatOp *op)
+{
+  const char *end;
+
+  if(!(op->options & FORMAT_PRECISION)) {
+    return (int)strlen(string);
   }
+  end = memchr(string, '\0', op->precision);
 
-  return pc;
+  return (end != NULL) ? (int)(end - string) : op->precision;
+}
+
+/**********************************************************************************************************************/
+/** Print String
+ ***********************************************************************************************************************
+ *
+ * The length is taken with strlen() / memchr(), unpadded strings are then handed to printspan as a single span.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyPrintString(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] String to print
+  const char *string,
+  /// [in] Conversion (s)
+  const TinyFormatOp *op)
+{
+  return TinyPrintPadded(printspan, ctx, string, TinyStringLength(string, op), op->width, op->options);
+}
+
+/**********************************************************************************************************************/
+/** Count leading zero bits of a nonzero 32 bit value
+ **********************************************************************************************************************/
+static int TinyClz(
+  /// [in] Value, must not be zero
+  unsigned int u)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clz(u) - (int)(sizeof(unsigned int) * 8 - 32);
+#else
+  int n = 0;
+  if(!(u & 0xFFFF0000u)) { n += 16; u <<= 16; }
+  if(!(u & 0xFF000000u)) { n += 8; u <<= 8; }
+  if(!(u & 0xF0000000u)) { n += 4; u <<= 4; }
+  if(!(u & 0xC0000000u)) { n += 2; u <<= 2; }
+  if(!(u & 0x80000000u)) { n += 1; }
+  return n;
+#endif
+}
+
+#ifndef TINY_PRINTF_NO_TABLES
+/// Decimal digit pairs "00" to "99"
+static const char tinyDigitPairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+/// Powers of ten correcting the digit count estimation
+static const unsigned int tinyPowersOf10[] = {
+  1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+#endif
+
+/**********************************************************************************************************************/
+/** Count decimal digits
+ ***********************************************************************************************************************
+ *
+ * @returns number of decimal digits of the value (1 for zero)
+ *
+ **********************************************************************************************************************/
+static int TinyDecimalDigits(
+  /// [in] Value
+  unsigned int u)
+{
+#ifndef TINY_PRINTF_NO_TABLES
+  // Estimate log10 from the bit length (1233 / 4096 ~ log10(2)), then correct it by one table lookup. Setting the
+  // lowest bit does not change the number of digits but takes care of zero.
+  int t = ((32 - TinyClz(u | 1)) * 1233) >> 12;
+  return t + 1 - ((u | 1) < tinyPowersOf10[t]);
+#else
+  int n = 1;
+  for(; u >= 10; u /= 10) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+/**********************************************************************************************************************/
+/** Write a fixed number of decimal digits
+ ***********************************************************************************************************************
+ *
+ * Writes exactly digits characters, values with less digits are padded with leading zeros.
+ *
+ **********************************************************************************************************************/
+static void TinyWriteDecimal(
+  /// [out] Destination, digits characters are written
+  char *s,
+  /// [in] Value
+  unsigned int u,
+  /// [in] Number of digits to write
+  int digits)
+{
+  s += digits;
+#ifndef TINY_PRINTF_NO_TABLES
+  // Two digits per division
+  for(; digits >= 2; digits -= 2) {
+    unsigned int q = u / 100;
+    s -= 2;
+    memcpy(s, &tinyDigitPairs[(u - q * 100) * 2], 2);
+    u = q;
+  }
+  if(digits) {
+    *--s = (char)('0' + u % 10);
+  }
+#else
+  for(; digits; --digits) {
+    *--s = (char)('0' + u % 10);
+    u /= 10;
+  }
+#endif
+}
+
+/**********************************************************************************************************************/
+/** Convert an integer to decimal digits
+ ***********************************************************************************************************************
+ *
+ * @returns number of characters written
+ *
+ **********************************************************************************************************************/
+static int TinyIntegerToDecimal(
+  /// [out] Destination, at least 10 characters
+  char *s,
+  /// [in] Value
+  unsigned int u)
+{
+  int digits = TinyDecimalDigits(u);
+  TinyWriteDecimal(s, u, digits);
+  return digits;
+}
+
+/**********************************************************************************************************************/
+/** Write a fixed number of hexadecimal digits
+ ***********************************************************************************************************************
+ *
+ * Writes exactly digits characters, values with less digits are padded with leading zeros.
+ *
+ **********************************************************************************************************************/
+static void TinyWriteHex(
+  /// [out] Destination, digits characters are written
+  char *s,
+  /// [in] Value
+  unsigned int u,
+  /// [in] Number of digits to write
+  int digits,
+  /// [in] Hexadecimal base character (lower / uppercase)
+  int letbase)
+{
+  for(s += digits; digits; --digits, u >>= 4) {
+    int t = u & 0xF;
+    *--s = (char)(t + ((t < 10) ? '0' : letbase - 10));
+  }
+}
+
+/**********************************************************************************************************************/
+/** Convert an integer to hexadecimal digits
+ ***********************************************************************************************************************
+ *
+ * @returns number of characters written
+ *
+ **********************************************************************************************************************/
+static int TinyIntegerToHex(
+  /// [out] Destination, at least 8 characters
+  char *s,
+  /// [in] Value
+  unsigned int u,
+  /// [in] Hexadecimal base character (lower / uppercase)
+  int letbase)
+{
+  // One digit per started nibble
+  int digits = (32 - TinyClz(u | 1) + 3) >> 2;
+  TinyWriteHex(s, u, digits, letbase);
+  return digits;
+}
+
+#if defined(TINY_PRINTF_LONG_LONG) || defined(TINY_PRINTF_FLOAT)
+/**********************************************************************************************************************/
+/** Convert a long long integer to decimal digits
+ ***********************************************************************************************************************
+ *
+ * The value is split into chunks of 8 digits, so only the split needs 64 bit divisions.
+ *
+ * @returns number of characters written
+ *
+ **********************************************************************************************************************/
+static int TinyLongLongToDecimal(
+  /// [out] Destination, at least 20 characters
+  char *s,
+  /// [in] Value
+  unsigned long long int u)
+{
+  unsigned long long int q;
+  int digits;
+
+  if(u <= 0xFFFFFFFFu) {
+    return TinyIntegerToDecimal(s, (unsigned int)u);
+  }
+
+  q = u / 100000000u;
+  digits = TinyLongLongToDecimal(s, q);
+  TinyWriteDecimal(s + digits, (unsigned int)(u - q * 100000000u), 8);
+
+  return digits + 8;
+}
+
+#endif
+
+#ifdef TINY_PRINTF_LONG_LONG
+/**********************************************************************************************************************/
+/** Convert a long long integer to hexadecimal digits
+ ***********************************************************************************************************************
+ *
+ * @returns number of characters written
+ *
+ **********************************************************************************************************************/
+static int TinyLongLongToHex(
+  /// [out] Destination, at least 16 characters
+  char *s,
+  /// [in] Value
+  unsigned long long int u,
+  /// [in] Hexadecimal base character (lower / uppercase)
+  int letbase)
+{
+  unsigned int high = (unsigned int)(u >> 32);
+  int digits;
+
+  if(high == 0) {
+    return TinyIntegerToHex(s, (unsigned int)u, letbase);
+  }
+
+  digits = TinyIntegerToHex(s, high, letbase);
+  TinyWriteHex(s + digits, (unsigned int)u, 8, letbase);
+
+  return digits + 8;
 }
+#endif
 
 /**********************************************************************************************************************/
 /** Print Integer Value Template
@@ -104,19 +463,23 @@ static int TinyPrintString(
  * @param FUNC_NAME       - Name of the function
  * @param INT_TYPE        - Type of the integer
  * @param PRINT_BUF_SIZE  - Size of the print buffer
+ * @param TO_DECIMAL      - Decimal conversion kernel for the unsigned type
+ * @param TO_HEX          - Hexadecimal conversion kernel for the unsigned type
+ *
+ * The base is always a constant at the call sites, so the kernel is selected at compile time.
  *
  * @returns number of bytes printed
  *
  **********************************************************************************************************************/
-#define TINY_PRINT_INTEGER(FUNC_NAME, INT_TYPE, PRINT_BUF_SIZE)                                                        \
+#define TINY_PRINT_INTEGER(FUNC_NAME, INT_TYPE, PRINT_BUF_SIZE, TO_DECIMAL, TO_HEX)                                    \
 static int FUNC_NAME(                                                                                                  \
-  /** [in] printchar function pointer */                                                                               \
-  printchar_t printchar,                                                                                               \
-  /** [in] context for printchar function */                                                                           \
+  /** [in] printspan function pointer */                                                                               \
+  printspan_t printspan,                                                                                               \
+  /** [in] context for printspan function */                                                                           \
   void* ctx,                                                                                                           \
   /** [in] Integer to print */                                                                                         \
   INT_TYPE i,                                                                                                          \
-  /** [in] Integer base to print */                                                                                    \
+  /** [in] Integer base to print (10 or 16) */                                                                         \
   int b,                                                                                                               \
   /** [in] Is integer signed? */                                                                                       \
   int sg,                                                                                                              \
@@ -128,290 +491,3932 @@ static int FUNC_NAME(
   int letbase)                                                                                                         \
 {                                                                                                                      \
   char print_buf[PRINT_BUF_SIZE];                                                                                      \
-  char *s;                                                                                                             \
-  int t, neg = 0, pc = 0;                                                                                              \
+  /* Leave space for the sign in front of the digits */                                                                \
+  char *s = print_buf + 1;                                                                                             \
+  int len, pc = 0;                                                                                                     \
+  char sign = 0;                                                                                                       \
   unsigned INT_TYPE u = i;                                                                                             \
                                                                                                                        \
-  if(i == 0) {                                                                                                         \
-    print_buf[0] = '0';                                                                                                \
-    print_buf[1] = '\0';                                                                                               \
-    return TinyPrintString(printchar, ctx, print_buf, width, options);                                                 \
-  }                                                                                                                    \
-                                                                                                                       \
-  if(sg && b == 10 && i < 0) {                                                                                         \
-    neg = 1;                                                                                                           \
-    u = -i;                                                                                                            \
-  }                                                                                                                    \
-                                                                                                                       \
-  s = print_buf + sizeof(print_buf) - 1;                                                                               \
-  *s = '\0';                                                                                                           \
-                                                                                                                       \
-  while(u) {                                                                                                           \
-    t = u % b;                                                                                                         \
-    if(t >= 10) {                                                                                                      \
-      t += letbase - '0' - 10;                                                                                         \
+  if(sg && b == 10) {                                                                                                  \
+    if(i < 0) {                                                                                                        \
+      sign = '-';                                                                                                      \
+      u = -u;                                                                                                          \
+    }                                                                                                                  \
+    else if(options & FORMAT_PLUS) {                                                                                   \
+      sign = '+';                                                                                                      \
+    }                                                                                                                  \
+    else if(options & FORMAT_SPACE) {                                                                                  \
+      sign = ' ';                                                                                                      \
     }                                                                                                                  \
-    *--s = t + '0';                                                                                                    \
-    u /= b;                                                                                                            \
   }                                                                                                                    \
                                                                                                                        \
-  if(neg) {                                                                                                            \
+  len = (b == 10) ? TO_DECIMAL(s, u) : TO_HEX(s, u, letbase);                                                          \
+                                                                                                                       \
+  if(sign) {                                                                                                           \
     if(width && (options & FORMAT_PAD_ZERO)) {                                                                         \
-      printchar(ctx, '-');                                                                                             \
+      printspan(ctx, &sign, 1);                                                                                        \
       ++pc;                                                                                                            \
       --width;                                                                                                         \
     }                                                                                                                  \
     else {                                                                                                             \
-      *--s = '-';                                                                                                      \
+      *--s = sign;                                                                                                     \
+      ++len;                                                                                                           \
     }                                                                                                                  \
   }                                                                                                                    \
                                                                                                                        \
-  return pc + TinyPrintString(printchar, ctx, s, width, options);                                                      \
+  return pc + TinyPrintPadded(printspan, ctx, s, len, width, options);                                                 \
 }
 
 /// Integer print function 32 bit version (Most digits at -2^31 = -2147483648)
-TINY_PRINT_INTEGER(TinyPrintInteger, int, sizeof("-2147483648"))
+TINY_PRINT_INTEGER(TinyPrintInteger, int, sizeof("-2147483648"), TinyIntegerToDecimal, TinyIntegerToHex)
 
 #ifdef TINY_PRINTF_LONG_LONG
 /// Integer print function 64 bit version (Most digits at -2^63 = -9223372036854775808)
-TINY_PRINT_INTEGER(TinyPrintIntegerLongLong, long long int, sizeof("-9223372036854775808"))
+TINY_PRINT_INTEGER(TinyPrintIntegerLongLong, long long int, sizeof("-9223372036854775808"), TinyLongLongToDecimal,
+                   TinyLongLongToHex)
 #endif
 
 /**********************************************************************************************************************/
-/** Print Floating Point Value Template
+/** Print Fixed Point Value Template
  ***********************************************************************************************************************
  *
  * @param FUNC_NAME       - Name of the function
- * @param FLOAT_TYPE      - Type of the floating point
+ * @param INT_TYPE        - Type of the integer
+ * @param PRINT_BUF_SIZE  - Size of the print buffer
+ * @param TO_DECIMAL      - Decimal conversion kernel for the unsigned type
  *
- * @returns number of bytes printed
+ * Prints a scaled integer as decimal fraction using only the integer kernels, e.g. 12345 with scale 2 as 123.45.
  *
- * @TODO: Make it work with width and options!
+ * @returns number of bytes printed
  *
  **********************************************************************************************************************/
-#define TINY_PRINT_FLOAT(FUNC_NAME, FLOAT_TYPE)                                                                        \
-static unsigned int FUNC_NAME(                                                                                         \
-  /** [in] printchar function pointer */                                                                               \
-  printchar_t printchar,                                                                                               \
-  /** [in] context for printchar function */                                                                           \
+#define TINY_PRINT_FIXED(FUNC_NAME, INT_TYPE, PRINT_BUF_SIZE, TO_DECIMAL)                                              \
+static int FUNC_NAME(                                                                                                  \
+  /** [in] printspan function pointer */                                                                               \
+  printspan_t printspan,                                                                                               \
+  /** [in] context for printspan function */                                                                           \
   void* ctx,                                                                                                           \
-  /** [in] Number to print */                                                                                          \
-  FLOAT_TYPE number,                                                                                                   \
-  /** [in] Precision (number of fractional digits to print, can be zero) */                                            \
-  unsigned int precision)                                                                                              \
+  /** [in] Scaled integer to print */                                                                                  \
+  INT_TYPE i,                                                                                                          \
+  /** [in] Number of decimal places, the value printed is i / 10^scale */                                              \
+  int scale,                                                                                                           \
+  /** [in] Desired Width */                                                                                            \
+  int width,                                                                                                           \
+  /** [in] Formatting options */                                                                                       \
+  int options)                                                                                                         \
 {                                                                                                                      \
-  unsigned int pc = 0, intPart, multiplier, i;                                                                         \
+  char print_buf[PRINT_BUF_SIZE];                                                                                      \
+  /* Leave space for moving the integer digits in front of the point */                                                \
+  char *s = print_buf + 1;                                                                                             \
+  int len, zeros = -1, pad, pc = 0;                                                                                    \
+  char sign = 0;                                                                                                       \
+  unsigned INT_TYPE u = i;                                                                                             \
                                                                                                                        \
-  /* If number is negative */                                                                                          \
-  if(number < 0) {                                                                                                     \
-    /* make it positive */                                                                                             \
-    number = -number;                                                                                                  \
-    /* and print sign */                                                                                               \
-    printchar(ctx, '-');                                                                                               \
-    pc++;                                                                                                              \
+  if(i < 0) {                                                                                                          \
+    sign = '-';                                                                                                        \
+    u = -u;                                                                                                            \
   }                                                                                                                    \
-                                                                                                                       \
-  /* calculate multiplier */                                                                                           \
-  for(i = 0, multiplier = 1; i < precision; i++) {                                                                     \
-    multiplier *= 10;                                                                                                  \
+  else if(options & FORMAT_PLUS) {                                                                                     \
+    sign = '+';                                                                                                        \
+  }                                                                                                                    \
+  else if(options & FORMAT_SPACE) {                                                                                    \
+    sign = ' ';                                                                                                        \
   }                                                                                                                    \
                                                                                                                        \
-  /* Round number */                                                                                                   \
-  number += (FLOAT_TYPE)0.5 / (FLOAT_TYPE)multiplier;                                                                  \
+  len = TO_DECIMAL(s, u);                                                                                              \
                                                                                                                        \
-  /* convert integer part to integer and print it */                                                                   \
-  intPart = (unsigned int)number;                                                                                      \
-  pc += TinyPrintInteger(printchar, ctx, intPart, 10, 0, 0, 0, 'a');                                                   \
+  if(len <= scale) {                                                                                                   \
+    /* No integer digits, "0." and zeros are printed in front of the digits */                                         \
+    zeros = scale - len;                                                                                               \
+  }                                                                                                                    \
+  else if(scale > 0 || (options & FORMAT_ALT)) {                                                                       \
+    memmove(s - 1, s, len - scale);                                                                                    \
+    --s;                                                                                                               \
+    s[len - scale] = '.';                                                                                              \
+    ++len;                                                                                                             \
+  }                                                                                                                    \
+  pad = width - len - (sign != 0) - ((zeros >= 0) ? zeros + 2 : 0);                                                    \
                                                                                                                        \
-  /* If we have to print fractional digits */                                                                          \
-  if(precision != 0) {                                                                                                 \
-    /* calculate fractional part as integer */                                                                         \
-    unsigned int fracPart = (unsigned int)((number - (FLOAT_TYPE)intPart) * (FLOAT_TYPE)multiplier);                   \
-    /* and print it along the period sign */                                                                           \
-    printchar(ctx, '.');                                                                                               \
-    pc++;                                                                                                              \
-    pc += TinyPrintInteger(printchar, ctx, fracPart, 10, 0, precision, FORMAT_PAD_ZERO, 'a');                          \
+  if(!(options & (FORMAT_PAD_RIGHT | FORMAT_PAD_ZERO))) {                                                              \
+    pc += TinyPrintPad(printspan, ctx, ' ', pad);                                                                      \
+    pad = 0;                                                                                                           \
+  }                                                                                                                    \
+  if(sign) {                                                                                                           \
+    printspan(ctx, &sign, 1);                                                                                          \
+    ++pc;                                                                                                              \
+  }                                                                                                                    \
+  if(!(options & FORMAT_PAD_RIGHT)) {                                                                                  \
+    pc += TinyPrintPad(printspan, ctx, '0', pad);                                                                      \
+    pad = 0;                                                                                                           \
   }                                                                                                                    \
+  if(zeros >= 0) {                                                                                                     \
+    printspan(ctx, "0.", 2);                                                                                           \
+    pc += 2 + TinyPrintPad(printspan, ctx, '0', zeros);                                                                \
+  }                                                                                                                    \
+  printspan(ctx, s, len);                                                                                              \
+  pc += len;                                                                                                           \
                                                                                                                        \
-  return pc;                                                                                                           \
+  return pc + TinyPrintPad(printspan, ctx, ' ', pad);                                                                  \
 }
 
-#ifdef TINY_PRINTF_FLOAT
-// Floating point print function with requested type
-TINY_PRINT_FLOAT(TinyPrintFloat, TINY_PRINTF_FLOAT)
+/// Fixed point print function 32 bit version
+TINY_PRINT_FIXED(TinyPrintFixed, int, sizeof("-2147483648"), TinyIntegerToDecimal)
+
+#ifdef TINY_PRINTF_LONG_LONG
+/// Fixed point print function 64 bit version
+TINY_PRINT_FIXED(TinyPrintFixedLongLong, long long int, sizeof("-9223372036854775808"), TinyLongLongToDecimal)
 #endif
 
+/// Hexadecimal digits, lower and uppercase
+static const char tinyHexDigits[] = "0123456789abcdef0123456789ABCDEF";
+
 /**********************************************************************************************************************/
-/** The printf function
+/** Encode bytes as hexadecimal digits
  ***********************************************************************************************************************
  *
- * A format specifier follows this prototype:
- * %[flags][width][.precision][length]specifier
+ * Writes 2 * n characters. Blocks of 16 or 32 bytes are converted with SSE2, AVX2 or NEON where the target supports
+ * them, nibbles are turned into digits by adding '0' and, for nibbles above 9, the distance to letbase.
+ *
+ **********************************************************************************************************************/
+static void TinyHexEncode(
+  /// [out] Destination
+  char *s,
+  /// [in] Bytes to encode
+  const unsigned char *data,
+  /// [in] Number of bytes
+  int n,
+  /// [in] Hexadecimal base character (lower / uppercase)
+  int letbase)
+{
+  const char *digits = &tinyHexDigits[(letbase == 'A') ? 16 : 0];
+
+#if defined(__AVX2__)
+  {
+    const __m256i mask = _mm256_set1_epi8(0x0F), nine = _mm256_set1_epi8(9), zero = _mm256_set1_epi8('0');
+    const __m256i letter = _mm256_set1_epi8((char)(letbase - '0' - 10));
+    for(; n >= 32; n -= 32, data += 32, s += 64) {
+      __m256i v = _mm256_loadu_si256((const __m256i *)data);
+      __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask), lo = _mm256_and_si256(v, mask);
+      hi = _mm256_add_epi8(_mm256_add_epi8(hi, zero), _mm256_and_si256(_mm256_cmpgt_epi8(hi, nine), letter));
+      lo = _mm256_add_epi8(_mm256_add_epi8(lo, zero), _mm256_and_si256(_mm256_cmpgt_epi8(lo, nine), letter));
+      // The unpacks work within 128 bit lanes, put the lanes back in order
+      v = _mm256_unpacklo_epi8(hi, lo);
+      hi = _mm256_unpackhi_epi8(hi, lo);
+      _mm256_storeu_si256((__m256i *)s, _mm256_permute2x128_si256(v, hi, 0x20));
+      _mm256_storeu_si256((__m256i *)(s + 32), _mm256_permute2x128_si256(v, hi, 0x31));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i mask = _mm_set1_epi8(0x0F), nine = _mm_set1_epi8(9), zero = _mm_set1_epi8('0');
+    const __m128i letter = _mm_set1_epi8((char)(letbase - '0' - 10));
+    for(; n >= 16; n -= 16, data += 16, s += 32) {
+      __m128i v = _mm_loadu_si128((const __m128i *)data);
+      __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask), lo = _mm_and_si128(v, mask);
+      hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter));
+      lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter));
+      _mm_storeu_si128((__m128i *)s, _mm_unpacklo_epi8(hi, lo));
+      _mm_storeu_si128((__m128i *)(s + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+  }
+#elif defined(__ARM_NEON)
+  {
+    const uint8x16_t mask = vdupq_n_u8(0x0F), nine = vdupq_n_u8(9), zero = vdupq_n_u8('0');
+    const uint8x16_t letter = vdupq_n_u8((uint8_t)(letbase - '0' - 10));
+    for(; n >= 16; n -= 16, data += 16, s += 32) {
+      uint8x16_t v = vld1q_u8(data);
+      uint8x16x2_t out;
+      out.val[0] = vshrq_n_u8(v, 4);
+      out.val[1] = vandq_u8(v, mask);
+      out.val[0] = vaddq_u8(vaddq_u8(out.val[0], zero), vandq_u8(vcgtq_u8(out.val[0], nine), letter));
+      out.val[1] = vaddq_u8(vaddq_u8(out.val[1], zero), vandq_u8(vcgtq_u8(out.val[1], nine), letter));
+      // Interleaving store: high nibble, low nibble
+      vst2q_u8((uint8_t *)s, out);
+    }
+  }
+#endif
+
+  for(; n; --n, ++data) {
+    *s++ = digits[*data >> 4];
+    *s++ = digits[*data & 0x0F];
+  }
+}
+
+/**********************************************************************************************************************/
+/** Get the number of bytes between two separators of a hex dump
+ **********************************************************************************************************************/
+static int TinyHexDumpGroup(
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Number of bytes to dump
+  int length)
+{
+  if(op->modifier == '\0') {
+    return length;
+  }
+  // Separator after every byte unless a precision gives the group size
+  return ((op->options & FORMAT_PRECISION) && op->precision > 0) ? op->precision : 1;
+}
+
+/**********************************************************************************************************************/
+/** Compute the length of a hex dump
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes the hex dump prints
+ *
+ **********************************************************************************************************************/
+static int TinyHexDumpLength(
+  /// [in] Bytes to dump
+  const void *data,
+  /// [in] Number of bytes to dump
+  int length,
+  /// [in] Conversion
+  const TinyFormatOp *op)
+{
+  if(data == NULL) {
+    return sizeof("(null)") - 1;
+  }
+  if(length <= 0) {
+    return 0;
+  }
+
+  return length * 2 + ((op->modifier != '\0') ? (length - 1) / TinyHexDumpGroup(op, length) : 0);
+}
+
+/**********************************************************************************************************************/
+/** Print a binary buffer as hex dump
+ ***********************************************************************************************************************
+ *
+ * Conversion of "%ph" (lowercase) and "%pH" (uppercase). The width gives the number of bytes, with '*' it is taken
+ * from the arguments in front of the pointer (a negative length dumps nothing). The suffixes C, D and S separate the
+ * bytes with ':', '-' or ' ', N (the default) prints them without separator. With a separator the precision gives the
+ * number of bytes per group.
  *
  * @returns number of bytes printed
  *
  **********************************************************************************************************************/
-int TinyPrintf(
-  /// [in] printchar function pointer
-  printchar_t printchar,
-  /// [in] context for printchar function
+int TinyFormatHexDump(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
   void* ctx,
-  /// [in] Format string
-  const char *format,
-  /// [in] Format arguments
-  va_list args)
+  /// [in] Bytes to dump
+  const void *data,
+  /// [in] Number of bytes to dump
+  int length,
+  /// [in] Conversion (h or H)
+  const TinyFormatOp *op)
 {
-  int width, options, precision;
-  int pc = 0;
+  const unsigned char *bytes = data;
+  char buf[256];
+  int letbase = (op->specifier == 'H') ? 'A' : 'a', group, pos = 0, used = 0, pc = 0;
 
-  for(; *format != 0; ++format) {
-    if(*format == '%') {
-      ++format;
-      width = options = 0;
-      // Default precision (at the moment only for floating point)
-      precision = 6;
-      if(*format == '\0') {
-        break;
-      }
-      if(*format == '%') {
-        goto out;
-      }
-      if(*format == '-') {
-        ++format;
-        options = FORMAT_PAD_RIGHT;
-      }
-      while(*format == '0') {
-        ++format;
-        options |= FORMAT_PAD_ZERO;
-      }
-      for(; *format >= '0' && *format <= '9'; ++format) {
-        width *= 10;
-        width += *format - '0';
+  if(data == NULL) {
+    printspan(ctx, "(null)", sizeof("(null)") - 1);
+    return sizeof("(null)") - 1;
+  }
+  group = TinyHexDumpGroup(op, length);
+
+  if(group == 1 && length > 1) {
+    // Separator after every byte: write "xx:" triples, leave the last separator out
+    const char *digits = &tinyHexDigits[(letbase == 'A') ? 16 : 0];
+    for(; pos < length; ++pos) {
+      buf[used++] = digits[bytes[pos] >> 4];
+      buf[used++] = digits[bytes[pos] & 0x0F];
+      buf[used++] = op->modifier;
+      if(sizeof(buf) - used < 3) {
+        used -= (pos == length - 1);
+        printspan(ctx, buf, used);
+        pc += used;
+        used = 0;
       }
-      if(*format == '.') {
-        ++format;
-        precision = 0;
-        for(; *format >= '0' && *format <= '9'; ++format) {
-          precision *= 10;
-          precision += *format - '0';
+    }
+    if(used != 0) {
+      printspan(ctx, buf, used - 1);
+      pc += used - 1;
+    }
+    return pc;
+  }
+
+  while(pos < length) {
+    // Up to the end of the group, as far as the buffer allows
+    int n = group - pos % group;
+    if(n > length - pos) {
+      n = length - pos;
+    }
+    if(n > (int)(sizeof(buf) - used - 1) / 2) {
+      n = (int)(sizeof(buf) - used - 1) / 2;
+    }
+    TinyHexEncode(buf + used, bytes + pos, n, letbase);
+    used += n * 2;
+    pos += n;
+    if(op->modifier != '\0' && pos % group == 0 && pos < length) {
+      buf[used++] = op->modifier;
+    }
+    if(sizeof(buf) - used < 3 || pos == length) {
+      printspan(ctx, buf, used);
+      pc += used;
+      used = 0;
+    }
+  }
+
+  return pc;
+}
+
+#ifdef TINY_PRINTF_TIMESTAMP
+/// Length of the date and time of ISO 8601 timestamps ("YYYY-MM-DDThh:mm:ss")
+#define TINY_TIMESTAMP_EXTENDED 19
+/// Length of the date and time of compact timestamps ("YYYYMMDDThhmmss")
+#define TINY_TIMESTAMP_COMPACT 15
+/// First second of year 0 (0000-01-01T00:00:00Z)
+#define TINY_TIMESTAMP_MIN (-62167219200LL)
+/// Last second of year 9999 (9999-12-31T23:59:59Z)
+#define TINY_TIMESTAMP_MAX 253402300799LL
+
+/**********************************************************************************************************************/
+/** Date and time of the last second printed, per layout
+ **********************************************************************************************************************/
+typedef struct {
+  /// Seconds since the epoch
+  long long int second;
+  /// Formatted date and time, empty if nothing is cached yet
+  char text[TINY_TIMESTAMP_EXTENDED];
+} TinyTimestampCache;
+
+/// One cache per thread and layout (extended, compact), so no locking is needed
+static TINY_PRINTF_THREAD_LOCAL TinyTimestampCache tinyTimestampCache[2];
+
+/// Divisors reducing nanoseconds to the number of sub-second digits
+static const unsigned int tinyTimestampDivisors[10] = {
+  1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+};
+
+/**********************************************************************************************************************/
+/** Get the number of sub-second digits of a timestamp conversion
+ **********************************************************************************************************************/
+static int TinyTimestampDigits(
+  /// [in] Conversion (T)
+  const TinyFormatOp *op)
+{
+  if(!(op->options & FORMAT_PRECISION)) {
+    return 0;
+  }
+
+  return (op->precision > 9) ? 9 : op->precision;
+}
+
+/**********************************************************************************************************************/
+/** Get the length of a timestamp conversion without padding
+ **********************************************************************************************************************/
+static int TinyTimestampLength(
+  /// [in] Conversion (T)
+  const TinyFormatOp *op)
+{
+  int digits = TinyTimestampDigits(op);
+  int len = (op->options & FORMAT_ALT) ? TINY_TIMESTAMP_COMPACT : TINY_TIMESTAMP_EXTENDED;
+
+  // Date and time, '.' and the sub-second digits, 'Z'
+  return len + (digits ? digits + 1 : 0) + 1;
+}
+
+/**********************************************************************************************************************/
+/** Format the date and time of a second
+ ***********************************************************************************************************************
+ *
+ * The civil date is computed from the days since the epoch without any library calls (proleptic Gregorian calendar,
+ * years 0 to 9999).
+ *
+ **********************************************************************************************************************/
+static void TinyTimestampFormat(
+  /// [out] Destination, TINY_TIMESTAMP_EXTENDED or TINY_TIMESTAMP_COMPACT characters are written
+  char *s,
+  /// [in] Seconds since the epoch
+  long long int second,
+  /// [in] Compact layout?
+  int compact)
+{
+  long long int days = second / 86400, era;
+  unsigned int time, doe, yoe, doy, mp;
+  int year, month, day;
+
+  // Round towards minus infinity for times before the epoch
+  if(second % 86400 < 0) {
+    --days;
+  }
+  time = (unsigned int)(second - days * 86400);
+
+  // Shift the epoch to 0000-03-01, so leap days are at the end of the (400 year) era
+  days += 719468;
+  era = ((days >= 0) ? days : days - 146096) / 146097;
+  doe = (unsigned int)(days - era * 146097);
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp = (5 * doy + 2) / 153;
+  day = (int)(doy - (153 * mp + 2) / 5 + 1);
+  month = (mp < 10) ? (int)mp + 3 : (int)mp - 9;
+  year = (int)(yoe + era * 400) + (month <= 2);
+
+  TinyWriteDecimal(s, (unsigned int)year, 4);
+  if(compact) {
+    TinyWriteDecimal(s + 4, (unsigned int)month, 2);
+    TinyWriteDecimal(s + 6, (unsigned int)day, 2);
+    s[8] = 'T';
+    TinyWriteDecimal(s + 9, time / 3600, 2);
+    TinyWriteDecimal(s + 11, time / 60 % 60, 2);
+    TinyWriteDecimal(s + 13, time % 60, 2);
+  }
+  else {
+    memcpy(s + 4, "-MM-DDThh:mm:ss", 15);
+    TinyWriteDecimal(s + 5, (unsigned int)month, 2);
+    TinyWriteDecimal(s + 8, (unsigned int)day, 2);
+    TinyWriteDecimal(s + 11, time / 3600, 2);
+    TinyWriteDecimal(s + 14, time / 60 % 60, 2);
+    TinyWriteDecimal(s + 17, time % 60, 2);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Print a timestamp
+ ***********************************************************************************************************************
+ *
+ * Conversion of "%T" (struct timespec pointer) and "%llT" (nanoseconds since the epoch) as UTC timestamp. The ISO 8601
+ * layout "2024-05-17T08:30:00Z" is the default, '#' selects the compact layout "20240517T083000Z". The precision gives
+ * the number of sub-second digits (0 to 9). Times before year 0 or after year 9999 print as the first or last
+ * nanosecond of that range, so the layout keeps its length.
+ *
+ * The date and time of the last second printed are cached per thread, so consecutive timestamps only convert the
+ * sub-second digits.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyPrintTimestamp(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Seconds since the epoch
+  long long int second,
+  /// [in] Nanoseconds (0 to 999999999)
+  unsigned int nanosecond,
+  /// [in] Conversion (T)
+  const TinyFormatOp *op)
+{
+  int compact = (op->options & FORMAT_ALT) != 0, digits = TinyTimestampDigits(op);
+  int len = compact ? TINY_TIMESTAMP_COMPACT : TINY_TIMESTAMP_EXTENDED;
+  TinyTimestampCache *cache = &tinyTimestampCache[compact];
+  char buf[TINY_TIMESTAMP_EXTENDED + 11];
+
+  if(second < TINY_TIMESTAMP_MIN) {
+    second = TINY_TIMESTAMP_MIN;
+    nanosecond = 0;
+  }
+  else if(second > TINY_TIMESTAMP_MAX) {
+    second = TINY_TIMESTAMP_MAX;
+    nanosecond = 999999999;
+  }
+  else if(nanosecond > 999999999) {
+    // Not normalized struct timespec
+    nanosecond = 999999999;
+  }
+
+  if(cache->second != second || cache->text[0] == '\0') {
+    TinyTimestampFormat(cache->text, second, compact);
+    cache->second = second;
+  }
+  memcpy(buf, cache->text, len);
+
+  if(digits) {
+    buf[len++] = '.';
+    TinyWriteDecimal(buf + len, nanosecond / tinyTimestampDivisors[digits], digits);
+    len += digits;
+  }
+  buf[len++] = 'Z';
+
+  return TinyPrintPadded(printspan, ctx, buf, len, op->width, op->options);
+}
+#endif
+
+#ifdef TINY_PRINTF_FLOAT
+/**********************************************************************************************************************/
+/** Big unsigned integer used for exact floating point conversion
+ **********************************************************************************************************************/
+typedef struct {
+  /// Number of limbs used, zero for the value zero
+  int length;
+  /// 32 bit limbs, least significant first
+  unsigned int limb[TINY_PRINTF_FLOAT_LIMBS];
+} TinyBig;
+
+/**********************************************************************************************************************/
+/** Set a big integer
+ **********************************************************************************************************************/
+static void TinyBigSet(
+  /// [out] Big integer
+  TinyBig *a,
+  /// [in] Value
+  unsigned long long int v)
+{
+  for(a->length = 0; v != 0; v >>= 32) {
+    a->limb[a->length++] = (unsigned int)v;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Multiply a big integer by a small factor
+ **********************************************************************************************************************/
+static void TinyBigMulSmall(
+  /// [in,out] Big integer
+  TinyBig *a,
+  /// [in] Factor
+  unsigned int m)
+{
+  unsigned long long int carry = 0;
+  int i;
+
+  for(i = 0; i < a->length; i++) {
+    carry += (unsigned long long int)a->limb[i] * m;
+    a->limb[i] = (unsigned int)carry;
+    carry >>= 32;
+  }
+  if(carry != 0) {
+    a->limb[a->length++] = (unsigned int)carry;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Multiply a big integer by a power of ten
+ **********************************************************************************************************************/
+static void TinyBigMulPow10(
+  /// [in,out] Big integer
+  TinyBig *a,
+  /// [in] Exponent
+  int n)
+{
+  unsigned int m = 1;
+
+  for(; n >= 9; n -= 9) {
+    TinyBigMulSmall(a, 1000000000u);
+  }
+  for(; n > 0; n--) {
+    m *= 10;
+  }
+  TinyBigMulSmall(a, m);
+}
+
+/**********************************************************************************************************************/
+/** Shift a big integer to the left
+ **********************************************************************************************************************/
+static void TinyBigShiftLeft(
+  /// [in,out] Big integer
+  TinyBig *a,
+  /// [in] Number of bits to shift
+  int n)
+{
+  int words = n >> 5, bits = n & 31, i;
+
+  if(a->length == 0) {
+    return;
+  }
+  if(bits != 0) {
+    a->limb[a->length] = 0;
+    for(i = a->length; i > 0; i--) {
+      a->limb[i] = (a->limb[i] << bits) | (a->limb[i - 1] >> (32 - bits));
+    }
+    a->limb[0] <<= bits;
+    if(a->limb[a->length] != 0) {
+      a->length++;
+    }
+  }
+  if(words != 0) {
+    memmove(&a->limb[words], &a->limb[0], a->length * sizeof(a->limb[0]));
+    memset(&a->limb[0], 0, words * sizeof(a->limb[0]));
+    a->length += words;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Compare two big integers
+ ***********************************************************************************************************************
+ *
+ * @returns negative, zero or positive value if a is less than, equal or greater than b
+ *
+ **********************************************************************************************************************/
+static int TinyBigCompare(
+  /// [in] First big integer
+  const TinyBig *a,
+  /// [in] Second big integer
+  const TinyBig *b)
+{
+  int i;
+
+  if(a->length != b->length) {
+    return a->length - b->length;
+  }
+  for(i = a->length - 1; i >= 0; i--) {
+    if(a->limb[i] != b->limb[i]) {
+      return (a->limb[i] > b->limb[i]) ? 1 : -1;
+    }
+  }
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Add two big integers
+ **********************************************************************************************************************/
+static void TinyBigAdd(
+  /// [out] Sum
+  TinyBig *sum,
+  /// [in] First big integer
+  const TinyBig *a,
+  /// [in] Second big integer
+  const TinyBig *b)
+{
+  unsigned long long int carry = 0;
+  int i;
+
+  if(a->length < b->length) {
+    const TinyBig *t = a;
+    a = b;
+    b = t;
+  }
+  for(i = 0; i < a->length; i++) {
+    carry += a->limb[i];
+    if(i < b->length) {
+      carry += b->limb[i];
+    }
+    sum->limb[i] = (unsigned int)carry;
+    carry >>= 32;
+  }
+  sum->length = a->length;
+  if(carry != 0) {
+    sum->limb[sum->length++] = (unsigned int)carry;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Divide two big integers with a single decimal digit quotient
+ ***********************************************************************************************************************
+ *
+ * The divisor has to be normalized (most significant bit of its top limb set) and the quotient has to be less than
+ * ten. The dividend is replaced by the remainder.
+ *
+ * @returns quotient
+ *
+ **********************************************************************************************************************/
+static int TinyBigDivDigit(
+  /// [in,out] Dividend, remainder on return
+  TinyBig *r,
+  /// [in] Divisor
+  const TinyBig *s)
+{
+  int n = s->length, i;
+  unsigned long long int top, borrow = 0;
+  unsigned int q;
+
+  if(r->length < n) {
+    return 0;
+  }
+
+  // Estimate the quotient from the top limbs, thanks to the normalization it is at most one too small
+  top = (unsigned long long int)r->limb[n - 1];
+  if(r->length > n) {
+    top |= (unsigned long long int)r->limb[n] << 32;
+  }
+  q = (unsigned int)(top / ((unsigned long long int)s->limb[n - 1] + 1));
+
+  if(q != 0) {
+    for(i = 0; i < r->length; i++) {
+      unsigned long long int product = (i < n) ? (unsigned long long int)s->limb[i] * q + borrow : borrow;
+      unsigned int low = (unsigned int)product;
+      borrow = (product >> 32) + (r->limb[i] < low);
+      r->limb[i] -= low;
+    }
+    while(r->length > 0 && r->limb[r->length - 1] == 0) {
+      r->length--;
+    }
+  }
+
+  // Correct the estimation
+  while(TinyBigCompare(r, s) >= 0) {
+    borrow = 0;
+    for(i = 0; i < r->length; i++) {
+      unsigned long long int sub = ((i < n) ? s->limb[i] : 0) + borrow;
+      borrow = r->limb[i] < sub;
+      r->limb[i] -= (unsigned int)sub;
+    }
+    while(r->length > 0 && r->limb[r->length - 1] == 0) {
+      r->length--;
+    }
+    q++;
+  }
+
+  return (int)q;
+}
+
+/**********************************************************************************************************************/
+/** Bit length of a 64 bit value
+ **********************************************************************************************************************/
+static int TinyBitLength(
+  /// [in] Value
+  unsigned long long int v)
+{
+  unsigned int high = (unsigned int)(v >> 32);
+
+  if(high != 0) {
+    return 64 - TinyClz(high);
+  }
+
+  return (v != 0) ? 32 - TinyClz((unsigned int)v) : 0;
+}
+
+/**********************************************************************************************************************/
+/** Floating point value split into its parts
+ **********************************************************************************************************************/
+typedef struct {
+  /// Mantissa including the hidden bit, the value is mant * 2^exp
+  unsigned long long int mant;
+  /// Binary exponent
+  int exp;
+  /// Number of explicit mantissa bits of the type
+  int mantBits;
+  /// Exponent of the subnormal numbers of the type
+  int minExp;
+  /// Sign bit
+  int neg;
+} TinyFloatParts;
+
+/**********************************************************************************************************************/
+/** Split a floating point value into its parts
+ ***********************************************************************************************************************
+ *
+ * The value is converted to TINY_PRINTF_FLOAT first, its bits are then examined with integer operations only.
+ *
+ * @returns 0 for finite values, 1 for infinity, 2 for not a number
+ *
+ **********************************************************************************************************************/
+static int TinyFloatDecompose(
+  /// [in] Value
+  double number,
+  /// [out] Parts of the value
+  TinyFloatParts *parts)
+{
+  unsigned long long int bits, frac;
+  int biased, expBits;
+
+  if(sizeof(TINY_PRINTF_FLOAT) == sizeof(float)) {
+    float value = (float)number;
+    unsigned int bits32;
+    memcpy(&bits32, &value, sizeof(bits32));
+    bits = bits32;
+    parts->mantBits = 23;
+    expBits = 8;
+  }
+  else {
+    double value = (double)(TINY_PRINTF_FLOAT)number;
+    memcpy(&bits, &value, sizeof(bits));
+    parts->mantBits = 52;
+    expBits = 11;
+  }
+
+  parts->neg = (int)(bits >> (parts->mantBits + expBits)) & 1;
+  biased = (int)(bits >> parts->mantBits) & ((1 << expBits) - 1);
+  frac = bits & ((1ull << parts->mantBits) - 1);
+  // 1 - bias - mantissa bits
+  parts->minExp = 2 - (1 << (expBits - 1)) - parts->mantBits;
+
+  if(biased == 0) {
+    parts->mant = frac;
+    parts->exp = parts->minExp;
+  }
+  else {
+    parts->mant = frac | (1ull << parts->mantBits);
+    parts->exp = parts->minExp + biased - 1;
+  }
+
+  if(biased == (1 << expBits) - 1) {
+    return (frac != 0) ? 2 : 1;
+  }
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Exact decimal digit generator
+ ***********************************************************************************************************************
+ *
+ * Delivers the decimal digits of a floating point value one by one, starting with the most significant one. Values
+ * whose integer part fits into 64 bits and that have at most 60 fractional bits use 64 bit arithmetic, all others big
+ * integers.
+ *
+ **********************************************************************************************************************/
+typedef struct {
+  /// Decimal exponent of the first digit
+  int k;
+  /// Number of zeros to deliver before the first digit
+  int lead;
+  /// Use big integer arithmetic
+  int big;
+  /// Digits of the integer part (64 bit arithmetic)
+  char integer[20];
+  /// Number of integer part digits and the next one to deliver (64 bit arithmetic)
+  int intDigits, intPos;
+  /// Fractional part and its mask (64 bit arithmetic)
+  unsigned long long int frac, mask;
+  /// Number of fractional bits (64 bit arithmetic)
+  int fracBits;
+  /// Remainder, the next digit is r / s (big integer arithmetic)
+  TinyBig r;
+  /// Scale (big integer arithmetic)
+  TinyBig s;
+} TinyFloatDigits;
+
+/**********************************************************************************************************************/
+/** Start the digit generator
+ **********************************************************************************************************************/
+static void TinyFloatDigitsInit(
+  /// [out] Digit generator
+  TinyFloatDigits *g,
+  /// [in] Value
+  const TinyFloatParts *parts)
+{
+  unsigned long long int m = parts->mant;
+  int e = parts->exp, bitLength;
+
+  g->lead = 0;
+  g->intPos = 0;
+  g->big = 0;
+
+  if(m == 0) {
+    g->k = 0;
+    g->integer[0] = '0';
+    g->intDigits = 1;
+    g->frac = g->mask = 0;
+    g->fracBits = 0;
+    return;
+  }
+
+  // Trailing zero bits only make the numbers longer
+  for(; !(m & 1); m >>= 1) {
+    e++;
+  }
+  bitLength = TinyBitLength(m);
+
+  if(e >= 0 ? (e + bitLength <= 64) : (e >= -60)) {
+    unsigned long long int integer;
+
+    if(e >= 0) {
+      integer = m << e;
+      g->fracBits = 0;
+    }
+    else {
+      integer = m >> -e;
+      g->fracBits = -e;
+    }
+    g->mask = (1ull << g->fracBits) - 1;
+    g->frac = m & g->mask;
+
+    if(integer != 0) {
+      g->intDigits = TinyLongLongToDecimal(g->integer, integer);
+      g->k = g->intDigits - 1;
+    }
+    else {
+      // Skip the leading zeros of the fraction, 60 fractional bits times ten still fit into 64 bits
+      g->intDigits = 0;
+      for(g->k = -1; ((g->frac * 10) >> g->fracBits) == 0; g->k--) {
+        g->frac *= 10;
+      }
+    }
+  }
+  else {
+    int log2 = bitLength - 1 + e;
+
+    g->big = 1;
+    TinyBigSet(&g->r, m);
+    TinyBigSet(&g->s, 1);
+    if(e >= 0) {
+      TinyBigShiftLeft(&g->r, e);
+    }
+    else {
+      TinyBigShiftLeft(&g->s, -e);
+    }
+
+    // Estimate the decimal exponent (78913 / 2^18 ~ log10(2)), it is at most one too small. Scaling for one more
+    // guarantees r / s < 10, the loop fixes a too big scale.
+    g->k = (log2 >= 0) ? (log2 * 78913) >> 18 : -((-log2 * 78913 + (1 << 18) - 1) >> 18);
+    g->k++;
+    if(g->k >= 0) {
+      TinyBigMulPow10(&g->s, g->k);
+    }
+    else {
+      TinyBigMulPow10(&g->r, -g->k);
+    }
+    while(TinyBigCompare(&g->r, &g->s) < 0) {
+      TinyBigMulSmall(&g->r, 10);
+      g->k--;
+    }
+
+    // Normalize the scale for the quotient estimation
+    bitLength = TinyClz(g->s.limb[g->s.length - 1]);
+    TinyBigShiftLeft(&g->r, bitLength);
+    TinyBigShiftLeft(&g->s, bitLength);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Get the next decimal digit
+ **********************************************************************************************************************/
+static int TinyFloatDigitsNext(
+  /// [in,out] Digit generator
+  TinyFloatDigits *g)
+{
+  int d;
+
+  if(g->lead > 0) {
+    g->lead--;
+    return 0;
+  }
+  if(g->big) {
+    d = TinyBigDivDigit(&g->r, &g->s);
+    TinyBigMulSmall(&g->r, 10);
+    return d;
+  }
+  if(g->intPos < g->intDigits) {
+    return g->integer[g->intPos++] - '0';
+  }
+  g->frac *= 10;
+  d = (int)(g->frac >> g->fracBits);
+  g->frac &= g->mask;
+
+  return d;
+}
+
+/**********************************************************************************************************************/
+/** Decide the rounding after the last printed digit
+ ***********************************************************************************************************************
+ *
+ * Rounds to nearest, exact ties to even.
+ *
+ * @returns nonzero if the printed digits have to be rounded up
+ *
+ **********************************************************************************************************************/
+static int TinyFloatDigitsRoundUp(
+  /// [in,out] Digit generator
+  TinyFloatDigits *g,
+  /// [in] Last printed digit
+  int last)
+{
+  int d = TinyFloatDigitsNext(g), rest, i;
+
+  if(d != 5) {
+    return d > 5;
+  }
+
+  // Are there any nonzero digits behind?
+  if(g->lead > 0) {
+    rest = 1;
+  }
+  else if(g->big) {
+    rest = g->r.length != 0;
+  }
+  else {
+    for(rest = g->frac != 0, i = g->intPos; i < g->intDigits; i++) {
+      rest |= g->integer[i] != '0';
+    }
+  }
+
+  return rest || (last & 1);
+}
+
+/**********************************************************************************************************************/
+/** Examine the digits before printing them
+ ***********************************************************************************************************************
+ *
+ * Rounding can carry out of the printed digits only if they are all nines, so unless significant digits are
+ * requested this stops at the first digit other than nine.
+ *
+ * @returns nonzero if rounding carries out of the digits
+ *
+ **********************************************************************************************************************/
+static int TinyFloatDigitsScan(
+  /// [in,out] Digit generator, consumed
+  TinyFloatDigits *g,
+  /// [in] Number of digits to be printed
+  int n,
+  /// [out] Number of significant digits after rounding without the trailing zeros (NULL if not needed)
+  int *significant)
+{
+  int i, d = 0, lastNonNine = -1, lastNonZero = -1, roundUp;
+
+  for(i = 0; i < n; i++) {
+    d = TinyFloatDigitsNext(g);
+    if(d != 9) {
+      lastNonNine = i;
+      if(significant == NULL) {
+        return 0;
+      }
+    }
+    if(d != 0) {
+      lastNonZero = i;
+    }
+  }
+
+  roundUp = TinyFloatDigitsRoundUp(g, d);
+  if(significant != NULL) {
+    if(roundUp) {
+      *significant = (lastNonNine < 0) ? 1 : lastNonNine + 1;
+    }
+    else {
+      *significant = (lastNonZero < 0) ? 1 : lastNonZero + 1;
+    }
+  }
+
+  return roundUp && lastNonNine < 0;
+}
+
+/**********************************************************************************************************************/
+/** Buffered writer of the floating point conversions
+ **********************************************************************************************************************/
+typedef struct {
+  /// printspan function pointer
+  printspan_t printspan;
+  /// context for printspan function
+  void* ctx;
+  /// Number of bytes printed
+  int pc;
+  /// Number of digits written
+  int digits;
+  /// Number of digits after which the decimal point is written, -1 for none
+  int point;
+  /// Number of characters in the buffer
+  int length;
+  /// Buffer
+  char buf[32];
+} TinyFloatWriter;
+
+/**********************************************************************************************************************/
+/** Hand the buffered characters to the printspan function
+ **********************************************************************************************************************/
+static void TinyFloatFlush(
+  /// [in,out] Writer
+  TinyFloatWriter *w)
+{
+  if(w->length != 0) {
+    w->printspan(w->ctx, w->buf, w->length);
+    w->pc += w->length;
+    w->length = 0;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Write one character
+ **********************************************************************************************************************/
+static void TinyFloatPut(
+  /// [in,out] Writer
+  TinyFloatWriter *w,
+  /// [in] Character
+  char c)
+{
+  w->buf[w->length++] = c;
+  if(w->length == (int)sizeof(w->buf)) {
+    TinyFloatFlush(w);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Write digits, followed by the decimal point where it belongs
+ **********************************************************************************************************************/
+static void TinyFloatPutDigits(
+  /// [in,out] Writer
+  TinyFloatWriter *w,
+  /// [in] Digit character
+  char c,
+  /// [in] Number of times to write it
+  int count)
+{
+  for(; count > 0; count--) {
+    TinyFloatPut(w, c);
+    if(++w->digits == w->point) {
+      TinyFloatPut(w, '.');
+    }
+  }
+}
+
+/**********************************************************************************************************************/
+/** Write rounded digits from the generator
+ ***********************************************************************************************************************
+ *
+ * Rounding is resolved by holding back the last digit other than nine together with the nines following it. Must
+ * not be used if rounding carries out of the digits.
+ *
+ **********************************************************************************************************************/
+static void TinyFloatPutRounded(
+  /// [in,out] Writer
+  TinyFloatWriter *w,
+  /// [in,out] Digit generator
+  TinyFloatDigits *g,
+  /// [in] Number of digits to write
+  int n)
+{
+  int pending = TinyFloatDigitsNext(g), nines = 0, d;
+
+  for(; n > 1; n--) {
+    d = TinyFloatDigitsNext(g);
+    if(d == 9) {
+      nines++;
+    }
+    else {
+      TinyFloatPutDigits(w, (char)('0' + pending), 1);
+      TinyFloatPutDigits(w, '9', nines);
+      pending = d;
+      nines = 0;
+    }
+  }
+
+  if(TinyFloatDigitsRoundUp(g, nines ? 9 : pending)) {
+    TinyFloatPutDigits(w, (char)('0' + pending + 1), 1);
+    TinyFloatPutDigits(w, '0', nines);
+  }
+  else {
+    TinyFloatPutDigits(w, (char)('0' + pending), 1);
+    TinyFloatPutDigits(w, '9', nines);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Compute the shortest digits that read back as the same value
+ ***********************************************************************************************************************
+ *
+ * Free format algorithm of Burger and Dybvig: digits are generated until the number is uniquely identified within the
+ * rounding interval of the value.
+ *
+ * @returns number of digits
+ *
+ **********************************************************************************************************************/
+static int TinyFloatShortest(
+  /// [in] Value, not zero
+  const TinyFloatParts *parts,
+  /// [out] Digits (at most 19)
+  char *digits,
+  /// [out] Decimal exponent of the first digit
+  int *exponent)
+{
+  TinyBig r, s, mPlus, mMinus, t;
+  unsigned long long int m = parts->mant;
+  int e = parts->exp, even = !(m & 1), n = 0, k, log2, shift, low, high, d;
+  // The lower neighbour is closer at the powers of two
+  int closer = (m == (1ull << parts->mantBits)) && (e > parts->minExp);
+
+  // value = r / s, the rounding interval is (r - mMinus) / s ... (r + mPlus) / s
+  TinyBigSet(&r, m);
+  TinyBigSet(&s, 1);
+  TinyBigSet(&mPlus, 1);
+  TinyBigSet(&mMinus, 1);
+  if(e >= 0) {
+    TinyBigShiftLeft(&r, e + 1 + closer);
+    TinyBigShiftLeft(&s, 1 + closer);
+    TinyBigShiftLeft(&mPlus, e + closer);
+    TinyBigShiftLeft(&mMinus, e);
+  }
+  else {
+    TinyBigShiftLeft(&r, 1 + closer);
+    TinyBigShiftLeft(&s, 1 - e + closer);
+    TinyBigShiftLeft(&mPlus, closer);
+  }
+
+  // Estimate k so that the upper bound is just below 10^k, then correct it
+  log2 = TinyBitLength(m) - 1 + e;
+  k = ((log2 >= 0) ? (log2 * 78913) >> 18 : -((-log2 * 78913 + (1 << 18) - 1) >> 18)) + 1;
+  if(k >= 0) {
+    TinyBigMulPow10(&s, k);
+  }
+  else {
+    TinyBigMulPow10(&r, -k);
+    TinyBigMulPow10(&mPlus, -k);
+    TinyBigMulPow10(&mMinus, -k);
+  }
+  for(;;) {
+    TinyBigAdd(&t, &r, &mPlus);
+    high = TinyBigCompare(&t, &s);
+    if(even ? high < 0 : high <= 0) {
+      break;
+    }
+    TinyBigMulSmall(&s, 10);
+    k++;
+  }
+  for(;;) {
+    TinyBigAdd(&t, &r, &mPlus);
+    TinyBigMulSmall(&t, 10);
+    high = TinyBigCompare(&t, &s);
+    if(even ? high >= 0 : high > 0) {
+      break;
+    }
+    TinyBigMulSmall(&r, 10);
+    TinyBigMulSmall(&mPlus, 10);
+    TinyBigMulSmall(&mMinus, 10);
+    k--;
+  }
+
+  // Normalize the scale for the quotient estimation
+  shift = TinyClz(s.limb[s.length - 1]);
+  TinyBigShiftLeft(&r, shift);
+  TinyBigShiftLeft(&s, shift);
+  TinyBigShiftLeft(&mPlus, shift);
+  TinyBigShiftLeft(&mMinus, shift);
+
+  for(;;) {
+    TinyBigMulSmall(&r, 10);
+    TinyBigMulSmall(&mPlus, 10);
+    TinyBigMulSmall(&mMinus, 10);
+    d = TinyBigDivDigit(&r, &s);
+    // Would the number be within the rounding interval if stopped here (low) or rounded up here (high)?
+    low = TinyBigCompare(&r, &mMinus);
+    low = even ? low <= 0 : low < 0;
+    TinyBigAdd(&t, &r, &mPlus);
+    high = TinyBigCompare(&t, &s);
+    high = even ? high >= 0 : high > 0;
+    if(!low && !high && n < 19) {
+      digits[n++] = (char)('0' + d);
+      continue;
+    }
+    if(low && high) {
+      // Both are possible, take the nearer one (ties to even)
+      TinyBigAdd(&t, &r, &r);
+      high = TinyBigCompare(&t, &s);
+      d += (high > 0) || (high == 0 && (d & 1));
+    }
+    else {
+      d += high;
+    }
+    digits[n++] = (char)('0' + d);
+    break;
+  }
+
+  *exponent = k - 1;
+
+  return n;
+}
+/**********************************************************************************************************************/
+/** Print Floating Point Value
+ ***********************************************************************************************************************
+ *
+ * Handles the f, e, g conversions (uppercase as well) with exact rounding over the whole range of the type and the r
+ * conversion, which prints the shortest digits reading back as the same value in the style of g.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyPrintFloat(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Number to print
+  double number,
+  /// [in] Conversion
+  const TinyFormatOp *op)
+{
+  TinyFloatParts parts;
+  TinyFloatDigits digits;
+  TinyFloatWriter w;
+  char shortest[20];
+  int options = op->options, precision = op->precision, width = op->width;
+  int upper = (op->specifier >= 'A' && op->specifier <= 'Z'), specifier = op->specifier | 0x20;
+  int cls = TinyFloatDecompose(number, &parts);
+  int length, n = 0, lead = 0, carry = 0, exponent = 0, significant;
+  char sign = parts.neg ? '-' : (options & FORMAT_PLUS) ? '+' : (options & FORMAT_SPACE) ? ' ' : 0;
+
+  w.printspan = printspan;
+  w.ctx = ctx;
+  w.pc = 0;
+  w.digits = 0;
+  w.point = -1;
+  w.length = 0;
+
+  if(cls != 0) {
+    // Infinity and not a number are never padded with zeros
+    options &= ~FORMAT_PAD_ZERO;
+    length = 3;
+  }
+  else if(specifier == 'r') {
+    if(parts.mant == 0) {
+      shortest[0] = '0';
+      n = 1;
+    }
+    else {
+      n = TinyFloatShortest(&parts, shortest, &exponent);
+    }
+    if(exponent < -4 || exponent >= 17) {
+      specifier = 'e';
+      if(n > 1) {
+        w.point = 1;
+      }
+      length = n + 2 + ((exponent >= 100 || exponent <= -100) ? 3 : 2);
+    }
+    else {
+      specifier = 'f';
+      // Zeros in front of the digits if below one, behind the digits if they do not reach the decimal point
+      lead = (exponent < 0) ? -exponent : 0;
+      length = (lead + n > exponent + 1) ? lead + n : exponent + 1;
+      carry = length - lead - n;
+      if(length > ((exponent < 0) ? 1 : exponent + 1)) {
+        w.point = (exponent < 0) ? 1 : exponent + 1;
+      }
+    }
+    length += (w.point > 0);
+  }
+  else {
+    if(specifier == 'g') {
+      // Round to the significant digits, then print as f or e without the trailing zeros
+      int p = precision ? precision : 1;
+      TinyFloatDigitsInit(&digits, &parts);
+      exponent = digits.k + TinyFloatDigitsScan(&digits, p, &significant);
+      if(exponent < p && exponent >= -4) {
+        specifier = 'f';
+        precision = (options & FORMAT_ALT) ? p - 1 - exponent : significant - 1 - exponent;
+        if(precision < 0) {
+          precision = 0;
+        }
+      }
+      else {
+        specifier = 'e';
+        precision = (options & FORMAT_ALT) ? p - 1 : significant - 1;
+      }
+    }
+
+    TinyFloatDigitsInit(&digits, &parts);
+    if(specifier == 'f') {
+      // Digits from the ones (or the first digit if above) down to the last decimal
+      n = ((digits.k > 0) ? digits.k : 0) + 1 + precision;
+      lead = (digits.k < 0) ? -digits.k : 0;
+    }
+    else {
+      n = precision + 1;
+    }
+    // Rounding can only carry out of the digits if there are no leading zeros
+    if(lead == 0) {
+      carry = TinyFloatDigitsScan(&digits, n, NULL);
+      TinyFloatDigitsInit(&digits, &parts);
+    }
+    digits.lead = lead;
+
+    if(specifier == 'f') {
+      length = ((digits.k > 0) ? digits.k : 0) + 1 + carry;
+      if(precision || (options & FORMAT_ALT)) {
+        w.point = length;
+        length += 1 + precision;
+      }
+    }
+    else {
+      exponent = (parts.mant != 0) ? digits.k + carry : 0;
+      length = 1 + 2 + ((exponent >= 100 || exponent <= -100) ? 3 : 2);
+      if(precision || (options & FORMAT_ALT)) {
+        w.point = 1;
+        length += 1 + precision;
+      }
+    }
+  }
+
+  length += (sign != 0);
+  width = (width > length) ? width - length : 0;
+
+  if(!(options & (FORMAT_PAD_RIGHT | FORMAT_PAD_ZERO))) {
+    w.pc += TinyPrintPad(printspan, ctx, ' ', width);
+  }
+  if(sign) {
+    TinyFloatPut(&w, sign);
+  }
+  if((options & (FORMAT_PAD_RIGHT | FORMAT_PAD_ZERO)) == FORMAT_PAD_ZERO) {
+    TinyFloatFlush(&w);
+    w.pc += TinyPrintPad(printspan, ctx, '0', width);
+  }
+
+  if(cls != 0) {
+    const char *text = (cls == 1) ? "infINF" : "nanNAN";
+    TinyFloatFlush(&w);
+    printspan(ctx, text + 3 * upper, 3);
+    w.pc += 3;
+  }
+  else {
+    if(op->specifier == 'r') {
+      int i;
+      TinyFloatPutDigits(&w, '0', lead);
+      for(i = 0; i < n; i++) {
+        TinyFloatPutDigits(&w, shortest[i], 1);
+      }
+      // Trailing zeros before the decimal point
+      TinyFloatPutDigits(&w, '0', (specifier == 'f') ? carry : 0);
+    }
+    else if(carry) {
+      // All digits were nines and rounded up
+      TinyFloatPutDigits(&w, '1', 1);
+      TinyFloatPutDigits(&w, '0', (specifier == 'f') ? n : n - 1);
+    }
+    else {
+      TinyFloatPutRounded(&w, &digits, n);
+    }
+
+    if(specifier == 'e') {
+      TinyFloatPut(&w, upper ? 'E' : 'e');
+      TinyFloatPut(&w, (exponent < 0) ? '-' : '+');
+      if(exponent < 0) {
+        exponent = -exponent;
+      }
+      if(exponent >= 100) {
+        TinyFloatPut(&w, (char)('0' + exponent / 100));
+        exponent %= 100;
+      }
+      TinyFloatPut(&w, (char)('0' + exponent / 10));
+      TinyFloatPut(&w, (char)('0' + exponent % 10));
+    }
+    TinyFloatFlush(&w);
+  }
+
+  if(options & FORMAT_PAD_RIGHT) {
+    w.pc += TinyPrintPad(printspan, ctx, ' ', width);
+  }
+
+  return w.pc;
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Print a character span padded to the desired width
+ ***********************************************************************************************************************
+ *
+ * Conversion kernel entry point for front ends resolving the conversions at compile time (see tiny_printf.hpp).
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatPadded(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  int len,
+  /// [in] Desired Width
+  int width,
+  /// [in] Formatting options (TINY_FORMAT_*)
+  int options)
+{
+  return TinyPrintPadded(printspan, ctx, string, len, width, options);
+}
+
+/**********************************************************************************************************************/
+/** Print an integer
+ ***********************************************************************************************************************
+ *
+ * Conversion kernel entry point for front ends resolving the conversions at compile time (see tiny_printf.hpp).
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatInteger(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Integer to print
+  int i,
+  /// [in] Integer base to print (10 or 16)
+  int b,
+  /// [in] Is integer signed?
+  int sg,
+  /// [in] Desired Width
+  int width,
+  /// [in] Formatting options (TINY_FORMAT_*)
+  int options,
+  /// [in] Hexadecimal base character (lower / uppercase)
+  int letbase)
+{
+  return (b == 10) ? TinyPrintInteger(printspan, ctx, i, 10, sg, width, options, letbase) :
+                     TinyPrintInteger(printspan, ctx, i, 16, 0, width, options, letbase);
+}
+
+#ifdef TINY_PRINTF_LONG_LONG
+/**********************************************************************************************************************/
+/** Print a long long integer
+ ***********************************************************************************************************************
+ *
+ * Conversion kernel entry point for front ends resolving the conversions at compile time (see tiny_printf.hpp).
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatIntegerLongLong(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Integer to print
+  long long int i,
+  /// [in] Integer base to print (10 or 16)
+  int b,
+  /// [in] Is integer signed?
+  int sg,
+  /// [in] Desired Width
+  int width,
+  /// [in] Formatting options (TINY_FORMAT_*)
+  int options,
+  /// [in] Hexadecimal base character (lower / uppercase)
+  int letbase)
+{
+  return (b == 10) ? TinyPrintIntegerLongLong(printspan, ctx, i, 10, sg, width, options, letbase) :
+                     TinyPrintIntegerLongLong(printspan, ctx, i, 16, 0, width, options, letbase);
+}
+#endif
+
+#ifdef TINY_PRINTF_FLOAT
+/**********************************************************************************************************************/
+/** Print a floating point number
+ ***********************************************************************************************************************
+ *
+ * Conversion kernel entry point for front ends resolving the conversions at compile time (see tiny_printf.hpp).
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatFloat(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Number to print
+  double number,
+  /// [in] Conversion (f, F, e, E, g, G or r)
+  const TinyFormatOp *op)
+{
+  return TinyPrintFloat(printspan, ctx, number, op);
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Parse one format specifier
+ ***********************************************************************************************************************
+ *
+ * A format specifier follows this prototype:
+ * %[flags][width][.precision][length]specifier
+ *
+ * @returns pointer to the character following the specifier
+ *
+ **********************************************************************************************************************/
+static const char *TinyParseSpecifier(
+  /// [in] Format string pointing after the '%' character
+  const char *format,
+  /// [out] Parsed conversion
+  TinyFormatOp *op)
+{
+  int width = 0, options = 0;
+  // Default precision (at the moment only for floating point)
+  int precision = 6;
+
+  for(;; ++format) {
+    if(*format == '-') {
+      options |= FORMAT_PAD_RIGHT;
+    }
+    else if(*format == '0') {
+      options |= FORMAT_PAD_ZERO;
+    }
+    else if(*format == '+') {
+      options |= FORMAT_PLUS;
+    }
+    else if(*format == ' ') {
+      options |= FORMAT_SPACE;
+    }
+    else if(*format == '#') {
+      options |= FORMAT_ALT;
+    }
+    else {
+      break;
+    }
+  }
+  if(*format == '*') {
+    ++format;
+    width = TINY_FORMAT_STAR;
+  }
+  else {
+    for(; *format >= '0' && *format <= '9'; ++format) {
+      width *= 10;
+      width += *format - '0';
+    }
+  }
+  if(*format == '.') {
+    ++format;
+    options |= FORMAT_PRECISION;
+    precision = 0;
+    if(*format == '*') {
+      ++format;
+      precision = TINY_FORMAT_STAR;
+    }
+    else {
+      for(; *format >= '0' && *format <= '9'; ++format) {
+        precision *= 10;
+        precision += *format - '0';
+      }
+    }
+  }
+  if(*format == 'l') {
+    ++format;
+    if(*format == 'l') {
+      ++format;
+      options |= FORMAT_LONG_LONG;
+    }
+  }
+  // short and char arguments are promoted to int, so the h and hh modifiers do not change anything
+  for(; *format == 'h'; ++format);
+
+  op->specifier = *format;
+  op->options = options;
+  op->width = width;
+  op->precision = precision;
+  op->modifier = '\0';
+
+  // Hex dump "%ph" / "%pH" with an optional separator suffix
+  if(*format == 'p' && (format[1] == 'h' || format[1] == 'H')) {
+    op->specifier = *++format;
+    switch(format[1]) {
+      case 'C':
+        op->modifier = ':';
+        ++format;
+        break;
+      case 'D':
+        op->modifier = '-';
+        ++format;
+        break;
+      case 'S':
+        op->modifier = ' ';
+        ++format;
+        break;
+      case 'N':
+        ++format;
+        break;
+    }
+  }
+
+  // Do not run over the end of the format string
+  return (*format != '\0') ? format + 1 : format;
+}
+
+/**********************************************************************************************************************/
+/** Print a string conversion (s)
+ **********************************************************************************************************************/
+static int TinyConvertString(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  return TinyPrintString(printspan, ctx, arg->s ? arg->s : "(null)", op);
+}
+
+/**********************************************************************************************************************/
+/** Integer Conversion Template
+ ***********************************************************************************************************************
+ *
+ * @param FUNC_NAME  - Name of the function
+ * @param BASE       - Integer base to print (10 or 16)
+ * @param SIGNED     - Is integer signed?
+ * @param LETBASE    - Hexadecimal base character (lower / uppercase)
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+#ifdef TINY_PRINTF_LONG_LONG
+#define TINY_CONVERT_INTEGER(FUNC_NAME, BASE, SIGNED, LETBASE)                                                         \
+static int FUNC_NAME(printspan_t printspan, void* ctx, const TinyFormatOp *op, const TinyFormatArg *arg)               \
+{                                                                                                                      \
+  if(op->options & FORMAT_LONG_LONG) {                                                                                 \
+    return TinyPrintIntegerLongLong(printspan, ctx, arg->ll, BASE, SIGNED, op->width, op->options, LETBASE);           \
+  }                                                                                                                    \
+  return TinyPrintInteger(printspan, ctx, arg->i, BASE, SIGNED, op->width, op->options, LETBASE);                      \
+}
+#else
+#define TINY_CONVERT_INTEGER(FUNC_NAME, BASE, SIGNED, LETBASE)                                                         \
+static int FUNC_NAME(printspan_t printspan, void* ctx, const TinyFormatOp *op, const TinyFormatArg *arg)               \
+{                                                                                                                      \
+  return TinyPrintInteger(printspan, ctx, arg->i, BASE, SIGNED, op->width, op->options, LETBASE);                      \
+}
+#endif
+
+/// Signed decimal conversion (d)
+TINY_CONVERT_INTEGER(TinyConvertDecimal, 10, 1, 'a')
+/// Unsigned decimal conversion (u)
+TINY_CONVERT_INTEGER(TinyConvertUnsigned, 10, 0, 'a')
+/// Lowercase hexadecimal conversion (x)
+TINY_CONVERT_INTEGER(TinyConvertHex, 16, 0, 'a')
+/// Uppercase hexadecimal conversion (X)
+TINY_CONVERT_INTEGER(TinyConvertHexUpper, 16, 0, 'A')
+
+/**********************************************************************************************************************/
+/** Fixed point conversion (k)
+ ***********************************************************************************************************************
+ *
+ * The precision gives the number of decimal places, without precision the integer is printed as is.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyConvertFixed(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  int scale = (op->options & FORMAT_PRECISION) ? op->precision : 0;
+
+#ifdef TINY_PRINTF_LONG_LONG
+  if(op->options & FORMAT_LONG_LONG) {
+    return TinyPrintFixedLongLong(printspan, ctx, arg->ll, scale, op->width, op->options);
+  }
+#endif
+  return TinyPrintFixed(printspan, ctx, arg->i, scale, op->width, op->options);
+}
+
+/**********************************************************************************************************************/
+/** Print a pointer conversion (p)
+ **********************************************************************************************************************/
+static int TinyConvertPointer(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  (void)op;
+#ifdef TINY_PRINTF_LONG_LONG
+  if(sizeof(void *) > sizeof(int)) {
+    return TinyPrintIntegerLongLong(printspan, ctx, (long long int)(size_t)arg->p, 16, 0, sizeof(void *) * 2,
+                                    FORMAT_PAD_ZERO, 'A');
+  }
+#endif
+  return TinyPrintInteger(printspan, ctx, (int)(size_t)arg->p, 16, 0, sizeof(void *) * 2, FORMAT_PAD_ZERO, 'A');
+}
+
+/**********************************************************************************************************************/
+/** Print a character conversion (c)
+ **********************************************************************************************************************/
+static int TinyConvertChar(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  // This works with any byte, even with zero
+  char c = (char)arg->i;
+  return TinyPrintPadded(printspan, ctx, &c, 1, op->width, op->options);
+}
+
+/**********************************************************************************************************************/
+/** Print a hex dump conversion (ph, pH)
+ **********************************************************************************************************************/
+static int TinyConvertHexDump(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  return TinyFormatHexDump(printspan, ctx, arg->p, op->width, op);
+}
+
+#ifdef TINY_PRINTF_TIMESTAMP
+/**********************************************************************************************************************/
+/** Print a timestamp conversion (T, llT)
+ **********************************************************************************************************************/
+static int TinyConvertTimestamp(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  const struct timespec *time = arg->p;
+
+#ifdef TINY_PRINTF_LONG_LONG
+  if(op->options & FORMAT_LONG_LONG) {
+    long long int second = arg->ll / 1000000000, nanosecond = arg->ll % 1000000000;
+    if(nanosecond < 0) {
+      nanosecond += 1000000000;
+      --second;
+    }
+    return TinyPrintTimestamp(printspan, ctx, second, (unsigned int)nanosecond, op);
+  }
+#endif
+  if(time == NULL) {
+    return TinyPrintPadded(printspan, ctx, "(null)", sizeof("(null)") - 1, op->width, op->options);
+  }
+
+  return TinyPrintTimestamp(printspan, ctx, (long long int)time->tv_sec, (unsigned int)time->tv_nsec, op);
+}
+#endif
+
+#ifdef TINY_PRINTF_FLOAT
+/**********************************************************************************************************************/
+/** Print a floating point conversion (f, F, e, E, g, G, r)
+ **********************************************************************************************************************/
+static int TinyConvertFloat(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  return TinyPrintFloat(printspan, ctx, arg->f, op);
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Print nothing, conversion of unknown specifiers
+ **********************************************************************************************************************/
+static int TinyConvertNone(
+  /// [in] printspan function pointer (unused)
+  printspan_t printspan,
+  /// [in] context for printspan function (unused)
+  void* ctx,
+  /// [in] Conversion (unused)
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion (unused)
+  const TinyFormatArg *arg)
+{
+  (void)printspan;
+  (void)ctx;
+  (void)op;
+  (void)arg;
+  return 0;
+}
+
+/***********************************************************************************************************************
+ * Conversion table
+ **********************************************************************************************************************/
+/// Conversion table entry
+typedef struct {
+  /// Conversion function
+  convert_t convert;
+  /// Type of the argument the conversion consumes
+  TinyFormatArgType type;
+  /// Type of the argument the conversion consumes with the ll modifier
+  TinyFormatArgType typeLongLong;
+} TinyConversion;
+
+/// Slots of the built in conversions
+enum {
+  TINY_CONVERSION_NONE,
+  TINY_CONVERSION_STRING,
+  TINY_CONVERSION_DECIMAL,
+  TINY_CONVERSION_UNSIGNED,
+  TINY_CONVERSION_HEX,
+  TINY_CONVERSION_HEX_UPPER,
+  TINY_CONVERSION_POINTER,
+  TINY_CONVERSION_CHAR,
+  TINY_CONVERSION_HEX_DUMP,
+  TINY_CONVERSION_FIXED,
+#ifdef TINY_PRINTF_FLOAT
+  TINY_CONVERSION_FLOAT,
+#endif
+#ifdef TINY_PRINTF_TIMESTAMP
+  TINY_CONVERSION_TIMESTAMP,
+#endif
+  TINY_CONVERSION_BUILTIN
+};
+
+/// Conversions, the built in ones followed by the registered ones
+static TinyConversion tinyConversions[TINY_CONVERSION_BUILTIN + TINY_PRINTF_CUSTOM_CONVERSIONS] = {
+  { TinyConvertNone,      TINY_ARG_NONE,    TINY_ARG_NONE },
+  { TinyConvertString,    TINY_ARG_STRING,  TINY_ARG_STRING },
+  { TinyConvertDecimal,   TINY_ARG_INT,     TINY_ARG_LONG_LONG },
+  { TinyConvertUnsigned,  TINY_ARG_INT,     TINY_ARG_LONG_LONG },
+  { TinyConvertHex,       TINY_ARG_INT,     TINY_ARG_LONG_LONG },
+  { TinyConvertHexUpper,  TINY_ARG_INT,     TINY_ARG_LONG_LONG },
+  { TinyConvertPointer,   TINY_ARG_POINTER, TINY_ARG_POINTER },
+  // chars are converted to int then pushed on the stack
+  { TinyConvertChar,      TINY_ARG_INT,     TINY_ARG_INT },
+  { TinyConvertHexDump,   TINY_ARG_POINTER, TINY_ARG_POINTER },
+  { TinyConvertFixed,     TINY_ARG_INT,     TINY_ARG_LONG_LONG },
+#ifdef TINY_PRINTF_FLOAT
+  { TinyConvertFloat,     TINY_ARG_DOUBLE,  TINY_ARG_DOUBLE },
+#endif
+#ifdef TINY_PRINTF_TIMESTAMP
+  // struct timespec pointer or nanoseconds since the epoch
+  { TinyConvertTimestamp, TINY_ARG_POINTER, TINY_ARG_LONG_LONG },
+#endif
+};
+
+/// Number of used conversion slots
+static int tinyConversionCount = TINY_CONVERSION_BUILTIN;
+
+/// Conversion slot of every specifier character, unknown specifiers map to TINY_CONVERSION_NONE
+static unsigned char tinyConversionIndex[256] = {
+  ['s'] = TINY_CONVERSION_STRING,
+  ['d'] = TINY_CONVERSION_DECIMAL,
+  ['u'] = TINY_CONVERSION_UNSIGNED,
+  ['x'] = TINY_CONVERSION_HEX,
+  ['X'] = TINY_CONVERSION_HEX_UPPER,
+  ['p'] = TINY_CONVERSION_POINTER,
+  ['c'] = TINY_CONVERSION_CHAR,
+  // Hex dumps are parsed from "%ph" / "%pH"
+  ['h'] = TINY_CONVERSION_HEX_DUMP,
+  ['H'] = TINY_CONVERSION_HEX_DUMP,
+  ['k'] = TINY_CONVERSION_FIXED,
+#ifdef TINY_PRINTF_FLOAT
+  ['f'] = TINY_CONVERSION_FLOAT,
+  ['F'] = TINY_CONVERSION_FLOAT,
+  ['e'] = TINY_CONVERSION_FLOAT,
+  ['E'] = TINY_CONVERSION_FLOAT,
+  ['g'] = TINY_CONVERSION_FLOAT,
+  ['G'] = TINY_CONVERSION_FLOAT,
+  ['r'] = TINY_CONVERSION_FLOAT,
+#endif
+#ifdef TINY_PRINTF_TIMESTAMP
+  ['T'] = TINY_CONVERSION_TIMESTAMP,
+#endif
+};
+
+/// Get the conversion table entry of a specifier
+#define TINY_CONVERSION(specifier) (&tinyConversions[tinyConversionIndex[(unsigned char)(specifier)]])
+
+/**********************************************************************************************************************/
+/** Register a custom conversion
+ ***********************************************************************************************************************
+ *
+ * The conversion function receives the parsed conversion (flags, width, precision) and its argument, it can print
+ * padded text with TinyFormatPadded(). int conversions receive a long long argument with the ll modifier.
+ *
+ * Register conversions at start up, before any thread prints, the table is not protected against concurrent changes.
+ * At most TINY_PRINTF_CUSTOM_CONVERSIONS (default 8) conversions can be registered.
+ *
+ * @returns 0 or -1 if the specifier is already used, reserved for flags and modifiers or the table is full
+ *
+ **********************************************************************************************************************/
+int TinyFormatRegister(
+  /// [in] Specifier character
+  char specifier,
+  /// [in] Type of the argument the conversion consumes
+  TinyFormatArgType type,
+  /// [in] Conversion function
+  convert_t convert)
+{
+  unsigned char c = (unsigned char)specifier;
+
+  if(convert == NULL || c == '\0' || strchr("%-+ #.*0123456789lh", c) != NULL || tinyConversionIndex[c] != 0 ||
+     tinyConversionCount == TINY_CONVERSION_BUILTIN + TINY_PRINTF_CUSTOM_CONVERSIONS) {
+    return -1;
+  }
+
+  tinyConversions[tinyConversionCount].convert = convert;
+  tinyConversions[tinyConversionCount].type = type;
+  tinyConversions[tinyConversionCount].typeLongLong = (type == TINY_ARG_INT) ? TINY_ARG_LONG_LONG : type;
+  tinyConversionIndex[c] = (unsigned char)tinyConversionCount++;
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Get the argument type of a conversion
+ ***********************************************************************************************************************
+ *
+ * @returns type of the argument the conversion consumes
+ *
+ **********************************************************************************************************************/
+TinyFormatArgType TinyFormatGetArgType(
+  /// [in] Conversion
+  const TinyFormatOp *op)
+{
+#ifdef TINY_PRINTF_LONG_LONG
+  if(op->options & FORMAT_LONG_LONG) {
+    return TINY_CONVERSION(op->specifier)->typeLongLong;
+  }
+#endif
+
+  return TINY_CONVERSION(op->specifier)->type;
+}
+
+/**********************************************************************************************************************/
+/** Get the number of arguments of a conversion
+ ***********************************************************************************************************************
+ *
+ * A '*' width is consumed as TINY_ARG_INT in front of the argument of the conversion.
+ *
+ * @returns number of arguments the operation consumes
+ *
+ **********************************************************************************************************************/
+int TinyFormatGetArgCount(
+  /// [in] Operation
+  const TinyFormatOp *op)
+{
+  if(op->specifier == '\0') {
+    return 0;
+  }
+
+  return (op->width == TINY_FORMAT_STAR) + (op->precision == TINY_FORMAT_STAR) +
+         (TinyFormatGetArgType(op) != TINY_ARG_NONE);
+}
+
+/**********************************************************************************************************************/
+/** Resolve a '*' width
+ ***********************************************************************************************************************
+ *
+ * Negative widths mean left justification, as in printf(). A negative hex dump length dumps no bytes.
+ *
+ * @returns the resolved conversion
+ *
+ **********************************************************************************************************************/
+static const TinyFormatOp *TinyResolveWidth(
+  /// [in] Conversion with a '*' width
+  const TinyFormatOp *op,
+  /// [out] Resolved conversion (may be op itself)
+  TinyFormatOp *resolved,
+  /// [in] Width taken from the arguments
+  int width)
+{
+  *resolved = *op;
+  if(width < 0) {
+    if(op->specifier == 'h' || op->specifier == 'H') {
+      width = 0;
+    }
+    else {
+      resolved->options |= FORMAT_PAD_RIGHT;
+      width = -width;
+    }
+  }
+  resolved->width = width;
+
+  return resolved;
+}
+
+/**********************************************************************************************************************/
+/** Resolve a '*' precision
+ ***********************************************************************************************************************
+ *
+ * Negative precisions are taken as if the precision was omitted, as in printf().
+ *
+ * @returns the resolved conversion
+ *
+ **********************************************************************************************************************/
+static const TinyFormatOp *TinyResolvePrecision(
+  /// [in] Conversion with a '*' precision
+  const TinyFormatOp *op,
+  /// [out] Resolved conversion (may be op itself)
+  TinyFormatOp *resolved,
+  /// [in] Precision taken from the arguments
+  int precision)
+{
+  *resolved = *op;
+  if(precision < 0) {
+    resolved->options &= ~FORMAT_PRECISION;
+    precision = 6;
+  }
+  resolved->precision = precision;
+
+  return resolved;
+}
+
+/**********************************************************************************************************************/
+/** Fetch the '*' width and precision of one conversion
+ ***********************************************************************************************************************
+ *
+ * @returns the resolved conversion (op itself without '*')
+ *
+ **********************************************************************************************************************/
+static const TinyFormatOp *TinyFetchStars(
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [out] Resolved conversion (may be op itself)
+  TinyFormatOp *resolved,
+  /// [in,out] Format arguments
+  va_list *args)
+{
+  if(op->width == TINY_FORMAT_STAR) {
+    op = TinyResolveWidth(op, resolved, va_arg(*args, int));
+  }
+  if(op->precision == TINY_FORMAT_STAR) {
+    op = TinyResolvePrecision(op, resolved, va_arg(*args, int));
+  }
+
+  return op;
+}
+
+/**********************************************************************************************************************/
+/** Fetch the argument of one conversion
+ **********************************************************************************************************************/
+static void TinyFetchArg(
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [out] Fetched argument
+  TinyFormatArg *arg,
+  /// [in,out] Format arguments
+  va_list *args)
+{
+  switch(TinyFormatGetArgType(op)) {
+    case TINY_ARG_INT:
+      arg->i = va_arg(*args, int);
+      break;
+    case TINY_ARG_LONG_LONG:
+      arg->ll = va_arg(*args, long long int);
+      break;
+    case TINY_ARG_DOUBLE:
+      arg->f = va_arg(*args, double);
+      break;
+    case TINY_ARG_STRING:
+      arg->s = va_arg(*args, const char *);
+      break;
+    case TINY_ARG_POINTER:
+      arg->p = va_arg(*args, const void *);
+      break;
+    case TINY_ARG_NONE:
+      break;
+  }
+}
+
+#ifdef TINY_PRINTF_STATS
+/***********************************************************************************************************************
+ * Statistics
+ **********************************************************************************************************************/
+/// Counters of a group of threads
+typedef struct {
+  /// printf calls
+  TinyStatsCounter calls;
+  /// TinySNprintf() calls truncating their output
+  unsigned long long int truncations;
+  /// Conversions by specifier character
+  TinyStatsCounter conversions[256];
+  /// Calls by format string (the format strings are in tinyStatsFormats)
+  TinyStatsCounter formats[TINY_PRINTF_STATS_FORMATS];
+  /// Calls with format strings not fitting into the formats
+  TinyStatsCounter otherFormats;
+} TinyStatsShard;
+
+/// Counters, the first threads own a shard each, all further threads share the last one
+static TinyStatsShard tinyStatsShards[TINY_PRINTF_STATS_SHARDS];
+/// Shard shared by threads without a shard of their own
+#define TINY_STATS_SHARED (&tinyStatsShards[TINY_PRINTF_STATS_SHARDS - 1])
+/// Format strings of the per format counters, shared by all shards
+static const char *tinyStatsFormats[TINY_PRINTF_STATS_FORMATS];
+/// Copies of the format strings, the formats need not outlive the statistics
+static char tinyStatsFormatTexts[TINY_PRINTF_STATS_FORMATS][TINY_PRINTF_STATS_FORMAT_TEXT];
+/// Set once the copy of a format string is complete
+static int tinyStatsFormatCopied[TINY_PRINTF_STATS_FORMATS];
+/// Number of threads which have counted something
+static unsigned int tinyStatsThreads;
+/// Shard of the current thread
+static TINY_PRINTF_THREAD_LOCAL TinyStatsShard *tinyStatsShard;
+
+/// Statistics counters are updated without ordering, they do not guard any other data
+#define TINY_STATS_ADD(p, v)    __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define TINY_STATS_LOAD(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define TINY_STATS_STORE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+/// Add to a counter of a shard: the owner thread needs no read-modify-write, the shared shard does
+#define TINY_STATS_COUNT(shard, p, v)                                                                                  \
+  (((shard) == TINY_STATS_SHARED) ? (void)TINY_STATS_ADD(p, v) : TINY_STATS_STORE(p, TINY_STATS_LOAD(p) + (v)))
+
+#if !defined(__x86_64__) && !defined(__i386__)
+/**********************************************************************************************************************/
+/** Read the monotonic clock
+ ***********************************************************************************************************************
+ *
+ * @returns nanoseconds
+ *
+ **********************************************************************************************************************/
+static unsigned long long int TinyStatsMonotonic(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (unsigned long long int)now.tv_sec * 1000000000u + (unsigned long long int)now.tv_nsec;
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Get the statistics shard of the current thread
+ ***********************************************************************************************************************
+ *
+ * The first TINY_PRINTF_STATS_SHARDS - 1 threads counting something get a shard of their own, which they update
+ * without locked instructions. Shards are not given back when a thread ends, later threads share the last shard.
+ *
+ **********************************************************************************************************************/
+static TinyStatsShard *TinyStatsGetShard(void)
+{
+  if(tinyStatsShard == NULL) {
+    unsigned int thread = TINY_STATS_ADD(&tinyStatsThreads, 1);
+    tinyStatsShard = (thread < TINY_PRINTF_STATS_SHARDS - 1) ? &tinyStatsShards[thread] : TINY_STATS_SHARED;
+  }
+
+  return tinyStatsShard;
+}
+
+/**********************************************************************************************************************/
+/** Count one call or conversion
+ **********************************************************************************************************************/
+static void TinyStatsAdd(
+  /// [in] Shard of the counter
+  const TinyStatsShard *shard,
+  /// [in,out] Counter
+  TinyStatsCounter *counter,
+  /// [in] Number of bytes produced
+  int bytes,
+  /// [in] Time spent
+  unsigned long long int ticks)
+{
+  TINY_STATS_COUNT(shard, &counter->count, 1);
+  TINY_STATS_COUNT(shard, &counter->bytes, (unsigned long long int)bytes);
+  TINY_STATS_COUNT(shard, &counter->ticks, ticks);
+}
+
+/**********************************************************************************************************************/
+/** Copy the start of a format string for the entry taken by the calling thread
+ ***********************************************************************************************************************
+ *
+ * The characters are stored atomically, so a concurrent TinyStatsReset() and a new owner at worst garble the text.
+ *
+ **********************************************************************************************************************/
+static void TinyStatsCopyFormat(
+  /// [in] Entry
+  size_t slot,
+  /// [in] Format string
+  const char *format)
+{
+  char *text = tinyStatsFormatTexts[slot];
+  int i;
+
+  for(i = 0; i < TINY_PRINTF_STATS_FORMAT_TEXT - 1 && format[i] != '\0' && format[i] != '\n'; i++) {
+    TINY_STATS_STORE(&text[i], format[i]);
+  }
+  TINY_STATS_STORE(&text[i], '\0');
+  __atomic_store_n(&tinyStatsFormatCopied[slot], 1, __ATOMIC_RELEASE);
+}
+
+/**********************************************************************************************************************/
+/** Count one printf call
+ ***********************************************************************************************************************
+ *
+ * The format gets an entry in a small open addressing table keyed by its address, the entry is claimed with a
+ * compare and swap. Formats not finding a free entry within a few probes are counted together.
+ *
+ **********************************************************************************************************************/
+static void TinyStatsCall(
+  /// [in] Format string
+  const char *format,
+  /// [in] Number of bytes produced
+  int bytes,
+  /// [in] Clock at the start of the call
+  unsigned long long int start)
+{
+  unsigned long long int ticks = TINY_PRINTF_STATS_CLOCK() - start;
+  size_t slot = ((size_t)format >> 3) % TINY_PRINTF_STATS_FORMATS;
+  TinyStatsShard *shard = TinyStatsGetShard();
+  int probe;
+
+  TinyStatsAdd(shard, &shard->calls, bytes, ticks);
+
+  for(probe = 0; probe < 4; probe++, slot = (slot + 1) % TINY_PRINTF_STATS_FORMATS) {
+    const char *current = TINY_STATS_LOAD(&tinyStatsFormats[slot]);
+    if(current == NULL) {
+      // A failed exchange loads the format which got the entry
+      __atomic_compare_exchange_n(&tinyStatsFormats[slot], &current, format, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+      if(current == NULL) {
+        current = format;
+        TinyStatsCopyFormat(slot, format);
+      }
+    }
+    if(current == format) {
+      TinyStatsAdd(shard, &shard->formats[slot], bytes, ticks);
+      return;
+    }
+  }
+
+  TinyStatsAdd(shard, &shard->otherFormats, bytes, ticks);
+}
+
+/**********************************************************************************************************************/
+/** Count one conversion
+ **********************************************************************************************************************/
+static void TinyStatsConversion(
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Number of bytes produced
+  int bytes,
+  /// [in] Clock at the start of the conversion
+  unsigned long long int start)
+{
+  TinyStatsShard *shard = TinyStatsGetShard();
+
+  TinyStatsAdd(shard, &shard->conversions[(unsigned char)op->specifier], bytes, TINY_PRINTF_STATS_CLOCK() - start);
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Print one conversion
+ ***********************************************************************************************************************
+ *
+ * Dispatches on the specifier through the conversion table, unknown specifiers are skipped without printing anything.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyConvert(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+#ifdef TINY_PRINTF_STATS
+  unsigned long long int start = TINY_PRINTF_STATS_CLOCK();
+  int pc = TINY_CONVERSION(op->specifier)->convert(printspan, ctx, op, arg);
+
+  TinyStatsConversion(op, pc, start);
+  return pc;
+#else
+  return TINY_CONVERSION(op->specifier)->convert(printspan, ctx, op, arg);
+#endif
+}
+
+/**********************************************************************************************************************/
+/** Print one conversion
+ ***********************************************************************************************************************
+ *
+ * Entry point for front ends resolving the other conversions at compile time, e.g. for registered conversions.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatConvert(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  return TinyConvert(printspan, ctx, op, arg);
+}
+
+/**********************************************************************************************************************/
+/** Compile a format string
+ ***********************************************************************************************************************
+ *
+ * The format string is parsed once into a list of operations, each consisting of the literal text preceding a
+ * conversion and the conversion itself. The last operation may carry literal text only (specifier is '\0').
+ *
+ * The compiled format points into the format string, so the format string has to outlive it.
+ *
+ * @returns number of operations used or -1 if the operations buffer is too small
+ *
+ **********************************************************************************************************************/
+int TinyFormatCompile(
+  /// [out] Compiled format
+  TinyFormat *compiled,
+  /// [in] Buffer for the operations
+  TinyFormatOp *ops,
+  /// [in] Number of operations the buffer can hold
+  int maxOps,
+  /// [in] Format string
+  const char *format)
+{
+  int count = 0;
+
+  compiled->ops = ops;
+  compiled->count = 0;
+
+  while(*format != '\0') {
+    TinyFormatOp *op;
+    const char *start = format;
+
+    // Collect the literal run up to the next conversion ("%%" continues the literal run with a '%')
+    for(; *format != '\0' && *format != '%'; ++format);
+    if(count == maxOps) {
+      return -1;
+    }
+    op = &ops[count++];
+    op->literal = start;
+    op->literalLength = format - start;
+    op->specifier = '\0';
+
+    if(*format == '%') {
+      if(format[1] == '%') {
+        // Print the first '%' as the last literal character, continue after the second one
+        op->literalLength++;
+        format += 2;
+      }
+      else {
+        format = TinyParseSpecifier(format + 1, op);
+      }
+    }
+  }
+
+  compiled->count = count;
+
+  return count;
+}
+
+/**********************************************************************************************************************/
+/** Print using a compiled format
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TinyFormatRun(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in,out] Format arguments
+  va_list *args)
+{
+  const TinyFormatOp *op = compiled->ops, *end = compiled->ops + compiled->count;
+  TinyFormatOp resolved;
+  TinyFormatArg arg;
+  int pc = 0;
+
+  for(; op != end; ++op) {
+    if(op->literalLength != 0) {
+      printspan(ctx, op->literal, op->literalLength);
+      pc += op->literalLength;
+    }
+    if(op->specifier != '\0') {
+      const TinyFormatOp *conversion = TinyFetchStars(op, &resolved, args);
+      TinyFetchArg(conversion, &arg, args);
+      pc += TinyConvert(printspan, ctx, conversion, &arg);
+    }
+  }
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Print using a compiled format
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatExec(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Format arguments
+  va_list args)
+{
+  va_list ap;
+  int pc;
+
+  va_copy(ap, args);
+  pc = TinyFormatRun(compiled, printspan, ctx, &ap);
+  va_end(ap);
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Print using a compiled format and already fetched arguments
+ ***********************************************************************************************************************
+ *
+ * The arguments are given in the order they are consumed, see TinyFormatGetArgCount() and TinyFormatGetArgType().
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyFormatExecArgs(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Format arguments
+  const TinyFormatArg *args)
+{
+  const TinyFormatOp *op = compiled->ops, *end = compiled->ops + compiled->count;
+  TinyFormatOp resolved;
+  int pc = 0;
+
+  for(; op != end; ++op) {
+    if(op->literalLength != 0) {
+      printspan(ctx, op->literal, op->literalLength);
+      pc += op->literalLength;
+    }
+    if(op->specifier != '\0') {
+      const TinyFormatOp *conversion = op;
+      if(op->width == TINY_FORMAT_STAR) {
+        conversion = TinyResolveWidth(conversion, &resolved, (args++)->i);
+      }
+      if(op->precision == TINY_FORMAT_STAR) {
+        conversion = TinyResolvePrecision(conversion, &resolved, (args++)->i);
+      }
+      pc += TinyConvert(printspan, ctx, conversion, args);
+      if(TinyFormatGetArgType(op) != TINY_ARG_NONE) {
+        ++args;
+      }
+    }
+  }
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Fetch the arguments of a compiled format into an array
+ ***********************************************************************************************************************
+ *
+ * Stores the arguments in the order TinyFormatExecArgs() and TinyFormatStart() consume them, so the output can be
+ * produced after the variadic function returned.
+ *
+ * @returns number of arguments stored or -1 if the array is too small
+ *
+ **********************************************************************************************************************/
+int TinyFormatFetchArgs(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [out] Fetched arguments
+  TinyFormatArg *fetched,
+  /// [in] Number of arguments the array can hold
+  int maxArgs,
+  /// [in] Format arguments
+  va_list args)
+{
+  const TinyFormatOp *op = compiled->ops, *end = compiled->ops + compiled->count;
+  TinyFormatArg *arg = fetched;
+  va_list ap;
+
+  va_copy(ap, args);
+  for(; op != end; ++op) {
+    if(op->specifier != '\0') {
+      if(TinyFormatGetArgCount(op) > maxArgs - (arg - fetched)) {
+        va_end(ap);
+        return -1;
+      }
+      if(op->width == TINY_FORMAT_STAR) {
+        (arg++)->i = va_arg(ap, int);
+      }
+      if(op->precision == TINY_FORMAT_STAR) {
+        (arg++)->i = va_arg(ap, int);
+      }
+      if(TinyFormatGetArgType(op) != TINY_ARG_NONE) {
+        TinyFetchArg(op, arg++, &ap);
+      }
+    }
+  }
+  va_end(ap);
+
+  return arg - fetched;
+}
+
+/**********************************************************************************************************************/
+/** Start an incremental formatting
+ ***********************************************************************************************************************
+ *
+ * The arguments are given in the order they are consumed, see TinyFormatFetchArgs(). The compiled format, the
+ * arguments and the data they point to have to stay valid until TinyFormatStep() returned 0.
+ *
+ **********************************************************************************************************************/
+void TinyFormatStart(
+  /// [out] Formatting state
+  TinyFormatState *state,
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [in] Format arguments
+  const TinyFormatArg *args)
+{
+  state->compiled = compiled;
+  state->args = args;
+  state->op = 0;
+  state->offset = 0;
+  state->more = 1;
+  state->dumped = 0;
+  state->pieceCount = 0;
+  state->piece = 0;
+}
+
+/// Collects the output of a conversion into the pieces of a formatting state
+typedef struct {
+  /// Formatting state
+  TinyFormatState *state;
+  /// Bytes to drop, they were delivered by earlier steps
+  size_t skip;
+  /// Characters of the text in use
+  int textUsed;
+  /// The characters printed stay valid (string conversion), they need not be copied
+  int stable;
+} TinyFormatCapture;
+
+/**********************************************************************************************************************/
+/** Copy characters of a conversion into the text of the formatting state
+ **********************************************************************************************************************/
+static void TinyFormatCaptureText(
+  /// [in,out] Capture
+  TinyFormatCapture *capture,
+  /// [in,out] Piece the characters belong to, the last one
+  TinyFormatPiece *piece,
+  /// [in] Characters
+  const char *string,
+  /// [in] Number of characters
+  size_t length)
+{
+  size_t n = (size_t)(TINY_PRINTF_STEP_TEXT - capture->textUsed);
+
+  if(n > length) {
+    n = length;
+  }
+  memcpy(capture->state->text + capture->textUsed, string, n);
+  capture->textUsed += (int)n;
+  piece->length += n;
+  // Drop the rest, it is converted again
+  capture->state->more = (n != length);
+}
+
+/**********************************************************************************************************************/
+/** Keep a span of bytes of a conversion in the formatting state
+ ***********************************************************************************************************************
+ *
+ * Runs of one character are kept as character and count, lasting strings as pointer, everything else is copied into
+ * the text. If the pieces or the text run out, the rest of the output is dropped and TinyFormatStep() converts again
+ * from there once the kept pieces have been delivered.
+ *
+ **********************************************************************************************************************/
+static void TinyFormatCaptureSpan(
+  /// [in] Pointer to the capture
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  TinyFormatCapture *capture = context;
+  TinyFormatState *state = capture->state;
+  TinyFormatPiece *last = (state->pieceCount != 0) ? &state->pieces[state->pieceCount - 1] : NULL;
+  size_t same;
+  int run;
+
+  if(length <= capture->skip) {
+    capture->skip -= length;
+    return;
+  }
+  string += capture->skip;
+  length -= capture->skip;
+  capture->skip = 0;
+  if(state->more) {
+    return;
+  }
+
+  for(same = 1; same < length && string[same] == string[0]; same++);
+  run = (same == length) ? (unsigned char)string[0] : -1;
+  if(run >= 0 && last != NULL && last->run == run) {
+    last->length += length;
+    return;
+  }
+  if(length < 8) {
+    // Not worth a piece of its own
+    run = -1;
+  }
+  if(run < 0 && !capture->stable && last != NULL && last->run < 0 && last->string == NULL) {
+    TinyFormatCaptureText(capture, last, string, length);
+    return;
+  }
+  if(state->pieceCount == TINY_PRINTF_STEP_PIECES) {
+    state->more = 1;
+    return;
+  }
+
+  last = &state->pieces[state->pieceCount++];
+  last->string = NULL;
+  last->length = 0;
+  last->run = run;
+  if(run >= 0) {
+    last->length = length;
+  }
+  else if(capture->stable) {
+    last->string = string;
+    last->length = length;
+  }
+  else {
+    TinyFormatCaptureText(capture, last, string, length);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Convert the next part of a conversion into the pieces of a formatting state
+ ***********************************************************************************************************************
+ *
+ * The output delivered by earlier steps is dropped. Hex dumps are converted a few bytes at a time instead, starting at
+ * a group boundary, so they cost the same for every step however long they are.
+ *
+ **********************************************************************************************************************/
+static void TinyFormatStepCapture(
+  /// [in,out] Formatting state
+  TinyFormatState *state,
+  /// [in] Conversion, stars resolved
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  convert_t convert = TINY_CONVERSION(op->specifier)->convert;
+  TinyFormatCapture capture;
+
+  capture.state = state;
+  capture.skip = state->offset - op->literalLength;
+  capture.textUsed = 0;
+  capture.stable = (convert == TinyConvertString);
+  state->more = 0;
+  state->pieceCount = 0;
+  state->piece = 0;
+  state->pieceOffset = 0;
+  state->textOffset = 0;
+
+  if(convert == TinyConvertHexDump && arg->p != NULL && op->width > 0) {
+    int length = op->width, pos = state->dumped, group = TinyHexDumpGroup(op, length), n;
+    int groups = (group < TINY_PRINTF_STEP_TEXT) ? TINY_PRINTF_STEP_TEXT / (2 * group + 1) : 0;
+    TinyFormatOp dump = *op;
+    TinyFormatArg bytes;
+
+    if(op->modifier != '\0' && groups > 0) {
+      // Whole groups with the separators between them
+      n = groups * group;
+    }
+    else {
+      // Up to the end of the group without separators
+      dump.modifier = '\0';
+      n = (TINY_PRINTF_STEP_TEXT - 1) / 2;
+      if(n > group - pos % group) {
+        n = group - pos % group;
+      }
+    }
+    if(n > length - pos) {
+      n = length - pos;
+    }
+    dump.width = n;
+    bytes.p = (const unsigned char *)arg->p + pos;
+    capture.skip = 0;
+    // A hex dump split between steps is counted with its first bytes
+    if(pos == 0) {
+      TinyConvert(TinyFormatCaptureSpan, &capture, &dump, &bytes);
+    }
+    else {
+      TinyFormatHexDump(TinyFormatCaptureSpan, &capture, bytes.p, n, &dump);
+    }
+    pos += n;
+    if(op->modifier != '\0' && pos % group == 0 && pos < length) {
+      TinyFormatCaptureSpan(&capture, &op->modifier, 1);
+    }
+    state->dumped = pos;
+    state->more = (pos < length);
+    return;
+  }
+
+  // A conversion split between steps is counted by the step it starts in
+  if(capture.skip == 0) {
+    TinyConvert(TinyFormatCaptureSpan, &capture, op, arg);
+  }
+  else {
+    convert(TinyFormatCaptureSpan, &capture, op, arg);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Continue an incremental formatting
+ ***********************************************************************************************************************
+ *
+ * Fills the buffer with as much of the output as fits and remembers where to continue, so arbitrarily long output can
+ * be produced in fixed size chunks without an intermediate buffer. Nothing is terminated with '\0'.
+ *
+ * Literal text is copied from where the previous step stopped. A conversion is converted once into a few pieces kept
+ * in the state: runs of one character (padding, zeros) as character and count, strings as pointer and the remaining
+ * characters (digits) in a small text buffer. Only if they do not fit into TINY_PRINTF_STEP_TEXT characters, they are
+ * converted again once the text is delivered. Hex dumps are converted a few bytes at a time, so every step costs about
+ * the same, however long the output of a conversion is.
+ *
+ * @returns number of bytes written, 0 once the whole output has been delivered (or the buffer length is 0)
+ *
+ **********************************************************************************************************************/
+size_t TinyFormatStep(
+  /// [in,out] Formatting state
+  TinyFormatState *state,
+  /// [out] Output buffer
+  char *buffer,
+  /// [in] Size of the output buffer
+  size_t length)
+{
+  char *string = buffer;
+  TinyFormatOp resolved;
+
+  while(state->op != state->compiled->count && length != 0) {
+    const TinyFormatOp *op = &state->compiled->ops[state->op];
+    const TinyFormatArg *arg = state->args;
+    size_t n;
+
+    if(state->offset < (size_t)op->literalLength) {
+      n = op->literalLength - state->offset;
+      if(n > length) {
+        n = length;
+      }
+      memcpy(string, op->literal + state->offset, n);
+      string += n;
+      length -= n;
+      state->offset += n;
+      continue;
+    }
+    if(op->specifier != '\0') {
+      const TinyFormatOp *conversion = op;
+      if(op->width == TINY_FORMAT_STAR) {
+        conversion = TinyResolveWidth(conversion, &resolved, (arg++)->i);
+      }
+      if(op->precision == TINY_FORMAT_STAR) {
+        conversion = TinyResolvePrecision(conversion, &resolved, (arg++)->i);
+      }
+      if(state->piece == state->pieceCount && state->more) {
+        TinyFormatStepCapture(state, conversion, arg);
+        continue;
+      }
+      if(state->piece != state->pieceCount) {
+        const TinyFormatPiece *piece = &state->pieces[state->piece];
+        n = piece->length - state->pieceOffset;
+        if(n > length) {
+          n = length;
+        }
+        if(piece->run >= 0) {
+          memset(string, piece->run, n);
+        }
+        else if(piece->string != NULL) {
+          memcpy(string, piece->string + state->pieceOffset, n);
+        }
+        else {
+          memcpy(string, state->text + state->textOffset + state->pieceOffset, n);
+        }
+        string += n;
+        length -= n;
+        state->offset += n;
+        state->pieceOffset += n;
+        if(state->pieceOffset == piece->length) {
+          if(piece->run < 0 && piece->string == NULL) {
+            state->textOffset += (int)piece->length;
+          }
+          state->piece++;
+          state->pieceOffset = 0;
+        }
+        continue;
+      }
+      if(TinyFormatGetArgType(op) != TINY_ARG_NONE) {
+        ++arg;
+      }
+    }
+    // The operation is complete
+    state->op++;
+    state->args = arg;
+    state->offset = 0;
+    state->more = 1;
+    state->dumped = 0;
+    state->pieceCount = 0;
+    state->piece = 0;
+  }
+
+  return string - buffer;
+}
+
+/**********************************************************************************************************************/
+/** Load the field of a batch record into an argument
+ **********************************************************************************************************************/
+static void TinyFormatLoadField(
+  /// [in] Argument type
+  TinyFormatArgType type,
+  /// [in] Field
+  const TinyFormatField *field,
+  /// [in] Record
+  const unsigned char *record,
+  /// [out] Argument of the conversion
+  TinyFormatArg *arg)
+{
+  const void *p = record + field->offset;
+  long long int value;
+  double number;
+
+  switch(field->type) {
+    case TINY_FIELD_CHAR:
+      value = *(const signed char *)p;
+      break;
+    case TINY_FIELD_UCHAR:
+      value = *(const unsigned char *)p;
+      break;
+    case TINY_FIELD_SHORT:
+      value = *(const short int *)p;
+      break;
+    case TINY_FIELD_USHORT:
+      value = *(const unsigned short int *)p;
+      break;
+    case TINY_FIELD_INT:
+      value = *(const int *)p;
+      break;
+    case TINY_FIELD_UINT:
+      value = *(const unsigned int *)p;
+      break;
+    case TINY_FIELD_LONG_LONG:
+      value = *(const long long int *)p;
+      break;
+    case TINY_FIELD_ULONG_LONG:
+      if(type == TINY_ARG_DOUBLE) {
+        arg->f = (double)*(const unsigned long long int *)p;
+        return;
+      }
+      // Integer conversions take the bits as they are, "%llu" prints them unsigned again
+      value = *(const long long int *)p;
+      break;
+    case TINY_FIELD_FLOAT:
+    case TINY_FIELD_DOUBLE:
+      number = (field->type == TINY_FIELD_FLOAT) ? *(const float *)p : *(const double *)p;
+      if(type == TINY_ARG_DOUBLE) {
+        arg->f = number;
+        return;
+      }
+      // Values out of the range of long long saturate and NaN gives 0, converting them would be undefined
+      if(number != number) {
+        value = 0;
+      }
+      else if(number >= 9223372036854775807.0) {
+        value = LLONG_MAX;
+      }
+      else if(number < -9223372036854775807.0) {
+        value = LLONG_MIN;
+      }
+      else {
+        value = (long long int)number;
+      }
+      break;
+    case TINY_FIELD_STRING:
+      arg->s = *(const char *const *)p;
+      return;
+    case TINY_FIELD_CHARS:
+      arg->s = p;
+      return;
+    case TINY_FIELD_POINTER:
+      arg->p = *(const void *const *)p;
+      return;
+    default:
+      value = 0;
+      break;
+  }
+
+  // Integer fields are converted to the argument type of the conversion
+  if(type == TINY_ARG_LONG_LONG) {
+    arg->ll = value;
+  }
+  else if(type == TINY_ARG_DOUBLE) {
+    arg->f = (double)value;
+  }
+  else {
+    arg->i = (int)value;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Context for the TinyFormatBatchSpan() function
+ **********************************************************************************************************************/
+typedef struct {
+  /// Current write pointer
+  char *string;
+  /// Number of bytes left in the buffer
+  size_t length;
+  /// Set if a span did not fit
+  int overflow;
+} TinyFormatBatchContext;
+
+/**********************************************************************************************************************/
+/** Put a span of bytes into the batch output buffer
+ **********************************************************************************************************************/
+static void TinyFormatBatchSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  TinyFormatBatchContext *ctx = context;
+
+  if(length > ctx->length) {
+    // The row gets rolled back, so the rest of it does not matter
+    ctx->overflow = 1;
+    ctx->length = 0;
+    return;
+  }
+  memcpy(ctx->string, string, length);
+  ctx->string += length;
+  ctx->length -= length;
+}
+
+/**********************************************************************************************************************/
+/** Write an integer conversion without width and flags directly into the output
+ ***********************************************************************************************************************
+ *
+ * @returns number of characters written or -1 if the conversion has to take the general path
+ *
+ **********************************************************************************************************************/
+static int TinyFormatBatchInteger(
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg,
+  /// [out] Destination, at least 21 characters
+  char *s)
+{
+  int neg;
+
+  if(op->width != 0 || (op->options & ~FORMAT_LONG_LONG) != 0) {
+    return -1;
+  }
+
+#ifdef TINY_PRINTF_LONG_LONG
+  if(op->options & FORMAT_LONG_LONG) {
+    unsigned long long int u = arg->ll;
+    switch(op->specifier) {
+      case 'd':
+        neg = arg->ll < 0;
+        *s = '-';
+        return neg + TinyLongLongToDecimal(s + neg, neg ? -u : u);
+      case 'u':
+        return TinyLongLongToDecimal(s, u);
+      case 'x':
+        return TinyLongLongToHex(s, u, 'a');
+      case 'X':
+        return TinyLongLongToHex(s, u, 'A');
+      default:
+        return -1;
+    }
+  }
+#endif
+
+  switch(op->specifier) {
+    case 'd':
+      neg = arg->i < 0;
+      *s = '-';
+      return neg + TinyIntegerToDecimal(s + neg, neg ? -(unsigned int)arg->i : (unsigned int)arg->i);
+    case 'u':
+      return TinyIntegerToDecimal(s, arg->i);
+    case 'x':
+      return TinyIntegerToHex(s, arg->i, 'a');
+    case 'X':
+      return TinyIntegerToHex(s, arg->i, 'A');
+    default:
+      return -1;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Print an array of records using a compiled format
+ ***********************************************************************************************************************
+ *
+ * The format is applied to every record, the rows are written one after the other into the buffer. fields gives the
+ * record field of every argument, in the order they are consumed (see TinyFormatGetArgCount()).
+ * Integer and floating point fields are converted to the argument type of their conversion.
+ *
+ * Only complete rows are written, the output is not null terminated. If the buffer fills up, call again with the
+ * remaining records.
+ *
+ * @returns number of rows written
+ *
+ **********************************************************************************************************************/
+int TinyFormatBatch(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [in] Record fields
+  const TinyFormatField *fields,
+  /// [in] Records
+  const void *records,
+  /// [in] Distance between records in bytes (sizeof() of the record)
+  size_t stride,
+  /// [in] Number of records
+  int count,
+  /// [out] Output buffer
+  char *buf,
+  /// [in] Size of the output buffer
+  size_t size,
+  /// [out] Offsets of the rows in the buffer, count + 1 entries, the last one is the end of the output (may be NULL)
+  size_t *offsets)
+{
+  const TinyFormatOp *end = compiled->ops + compiled->count;
+  const unsigned char *record = records;
+  TinyFormatBatchContext context;
+  TinyFormatOp resolved;
+  int row;
+
+  context.string = buf;
+  context.length = size;
+  context.overflow = 0;
+
+  for(row = 0; row < count; ++row, record += stride) {
+    const TinyFormatField *field = fields;
+    const TinyFormatOp *op;
+    char *start = context.string;
+
+    if(offsets != NULL) {
+      offsets[row] = start - buf;
+    }
+    for(op = compiled->ops; op != end; ++op) {
+      if(op->literalLength != 0) {
+        TinyFormatBatchSpan(&context, op->literal, op->literalLength);
+      }
+      if(op->specifier != '\0') {
+        const TinyFormatOp *conversion = op;
+        TinyFormatArgType type = TinyFormatGetArgType(op);
+        TinyFormatArg arg;
+        int len = -1;
+        if(op->width == TINY_FORMAT_STAR) {
+          TinyFormatLoadField(TINY_ARG_INT, field++, record, &arg);
+          conversion = TinyResolveWidth(conversion, &resolved, arg.i);
+        }
+        if(op->precision == TINY_FORMAT_STAR) {
+          TinyFormatLoadField(TINY_ARG_INT, field++, record, &arg);
+          conversion = TinyResolvePrecision(conversion, &resolved, arg.i);
+        }
+        if(type != TINY_ARG_NONE) {
+          TinyFormatLoadField(type, field++, record, &arg);
+        }
+        if(context.length >= sizeof("-9223372036854775808")) {
+          len = TinyFormatBatchInteger(conversion, &arg, context.string);
+        }
+        if(len >= 0) {
+          context.string += len;
+          context.length -= len;
+        }
+        else {
+          TinyConvert(TinyFormatBatchSpan, &context, conversion, &arg);
+        }
+      }
+    }
+    if(context.overflow) {
+      // Roll back the incomplete row
+      context.length += context.string - start;
+      context.string = start;
+      break;
+    }
+  }
+  if(offsets != NULL) {
+    offsets[row] = context.string - buf;
+  }
+
+  return row;
+}
+
+#ifdef TINY_PRINTF_FORMAT_CACHE
+/**********************************************************************************************************************/
+/** Compiled format cache entry
+ **********************************************************************************************************************/
+typedef struct {
+  /// Format string the entry was compiled from
+  const char *format;
+  /// Compiled format
+  TinyFormat compiled;
+  /// Operations of the compiled format
+  TinyFormatOp ops[TINY_PRINTF_FORMAT_CACHE_OPS];
+} TinyFormatCacheEntry;
+
+/// Direct mapped cache of compiled formats, one per thread so no locking is needed
+static TINY_PRINTF_THREAD_LOCAL TinyFormatCacheEntry tinyFormatCache[TINY_PRINTF_FORMAT_CACHE];
+
+/**********************************************************************************************************************/
+/** Look up a format string in the format cache, compile it on a miss
+ ***********************************************************************************************************************
+ *
+ * @returns compiled format or NULL if the format does not fit into a cache entry
+ *
+ **********************************************************************************************************************/
+static const TinyFormat *TinyFormatCacheLookup(
+  /// [in] Format string
+  const char *format)
+{
+  TinyFormatCacheEntry *entry = &tinyFormatCache[((size_t)format >> 2) % TINY_PRINTF_FORMAT_CACHE];
+
+  if(entry->format != format) {
+    entry->format = NULL;
+    if(TinyFormatCompile(&entry->compiled, entry->ops, TINY_PRINTF_FORMAT_CACHE_OPS, format) < 0) {
+      return NULL;
+    }
+    entry->format = format;
+  }
+
+  return &entry->compiled;
+}
+#endif
+
+/**********************************************************************************************************************/
+/** The printf function (span output)
+ ***********************************************************************************************************************
+ *
+ * A format specifier follows this prototype:
+ * %[flags][width][.precision][length]specifier
+ *
+ * Literal text between format specifiers, padding runs and converted values are each handed to printspan as a single
+ * span.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyPrintfSpan(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  va_list args)
+{
+  TinyFormatOp op;
+  TinyFormatArg arg;
+  va_list ap;
+  int pc = 0;
+#ifdef TINY_PRINTF_STATS
+  const char *fmt = format;
+  unsigned long long int start = TINY_PRINTF_STATS_CLOCK();
+#endif
+
+  va_copy(ap, args);
+
+#ifdef TINY_PRINTF_FORMAT_CACHE
+  {
+    const TinyFormat *compiled = TinyFormatCacheLookup(format);
+    if(compiled != NULL) {
+      pc = TinyFormatRun(compiled, printspan, ctx, &ap);
+      va_end(ap);
+#ifdef TINY_PRINTF_STATS
+      TinyStatsCall(fmt, pc, start);
+#endif
+      return pc;
+    }
+  }
+#endif
+
+  while(*format != 0) {
+    if(*format == '%') {
+      if(format[1] != '%') {
+        format = TinyParseSpecifier(format + 1, &op);
+        TinyFetchStars(&op, &op, &ap);
+        TinyFetchArg(&op, &arg, &ap);
+        pc += TinyConvert(printspan, ctx, &op, &arg);
+        continue;
+      }
+      // "%%" prints a '%' and continues the literal run
+      ++format;
+    }
+    {
+      // Print the whole literal run up to the next format specifier at once
+      const char *start = format;
+      for(++format; *format != '\0' && *format != '%'; ++format);
+      printspan(ctx, start, format - start);
+      pc += format - start;
+    }
+  }
+
+  va_end(ap);
+
+#ifdef TINY_PRINTF_STATS
+  TinyStatsCall(fmt, pc, start);
+#endif
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Context for the TinyPrintCharSpan() adapter
+ **********************************************************************************************************************/
+typedef struct {
+  /// printchar function pointer
+  printchar_t printchar;
+  /// context for printchar function
+  void *ctx;
+} TinyPrintCharSpanContext;
+
+/**********************************************************************************************************************/
+/** Adapt a printchar function to the printspan interface
+ **********************************************************************************************************************/
+static void TinyPrintCharSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  // This will spare us a lots of casts.
+  TinyPrintCharSpanContext *ctx = context;
+
+  for(; length != 0; --length) {
+    ctx->printchar(ctx->ctx, *string++);
+  }
+}
+
+/**********************************************************************************************************************/
+/** The printf function
+ ***********************************************************************************************************************
+ *
+ * A format specifier follows this prototype:
+ * %[flags][width][.precision][length]specifier
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyPrintf(
+  /// [in] printchar function pointer
+  printchar_t printchar,
+  /// [in] context for printchar function
+  void* ctx,
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  va_list args)
+{
+  TinyPrintCharSpanContext context;
+
+  context.printchar = printchar;
+  context.ctx = ctx;
+
+  return TinyPrintfSpan(TinyPrintCharSpan, &context, format, args);
+}
+
+#ifdef TINY_PRINTF_LONG_LONG
+/**********************************************************************************************************************/
+/** Count decimal digits of a long long integer
+ ***********************************************************************************************************************
+ *
+ * @returns number of decimal digits of the value (1 for zero)
+ *
+ **********************************************************************************************************************/
+static int TinyLongLongDecimalDigits(
+  /// [in] Value
+  unsigned long long int u)
+{
+  int digits = 0;
+
+  // Same chunks of 8 digits as TinyLongLongToDecimal()
+  for(; u > 0xFFFFFFFFu; u /= 100000000u) {
+    digits += 8;
+  }
+
+  return digits + TinyDecimalDigits((unsigned int)u);
+}
+#endif
+
+/**********************************************************************************************************************/
+/** printspan function discarding its input
+ **********************************************************************************************************************/
+static void TinyNullSpan(
+  /// [in] Context (unused)
+  void *ctx,
+  /// [in] Characters (unused)
+  const char *string,
+  /// [in] Number of characters (unused)
+  size_t length)
+{
+  (void)ctx;
+  (void)string;
+  (void)length;
+}
+
+/**********************************************************************************************************************/
+/** Compute the length of one conversion
+ ***********************************************************************************************************************
+ *
+ * Integers, fixed point numbers, strings and timestamps are measured arithmetically from their digit counts and
+ * lengths. Floating point numbers run through the conversion engine into a sink discarding the digits, as their digit
+ * count depends on the rounding. The same holds for registered conversions.
+ *
+ * @returns number of bytes the conversion prints
+ *
+ **********************************************************************************************************************/
+static int TinyMeasure(
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  int len = 0, sign = 0;
+
+  switch(op->specifier) {
+    case 's':
+      len = TinyStringLength(arg->s ? arg->s : "(null)", op);
+      break;
+    case 'c':
+      len = 1;
+      break;
+    case 'h':
+    case 'H':
+      return TinyHexDumpLength(arg->p, op->width, op);
+    case 'p':
+      // Printed with a fixed width, which holds all digits
+      return sizeof(void *) * 2;
+    case 'd':
+    case 'u':
+    case 'k':
+      sign = (op->specifier != 'u') && (op->options & (FORMAT_PLUS | FORMAT_SPACE));
+#ifdef TINY_PRINTF_LONG_LONG
+      if(op->options & FORMAT_LONG_LONG) {
+        unsigned long long int u = arg->ll;
+        if(op->specifier != 'u' && arg->ll < 0) {
+          sign = 1;
+          u = -u;
         }
+        len = TinyLongLongDecimalDigits(u);
+        break;
       }
-      if(*format == 'l') {
-        ++format;
-        if(*format == 'l') {
-          ++format;
-          options |= FORMAT_LONG_LONG;
+#endif
+      {
+        unsigned int u = arg->i;
+        if(op->specifier != 'u' && arg->i < 0) {
+          sign = 1;
+          u = -u;
         }
+        len = TinyDecimalDigits(u);
       }
-      if(*format == 's') {
-        char *s = va_arg(args, char *);
-        pc += TinyPrintString(printchar, ctx, s ? s : "(null)", width, options);
-        continue;
+      break;
+    case 'x':
+    case 'X':
+#ifdef TINY_PRINTF_LONG_LONG
+      if(op->options & FORMAT_LONG_LONG) {
+        unsigned int high = (unsigned int)((unsigned long long int)arg->ll >> 32);
+        // One digit per started nibble, 8 digits for the low half if the high half is not zero
+        len = high ? 8 + ((32 - TinyClz(high) + 3) >> 2) : (32 - TinyClz((unsigned int)arg->ll | 1) + 3) >> 2;
+        break;
       }
-      if(*format == 'd') {
-        pc +=
+#endif
+      len = (32 - TinyClz((unsigned int)arg->i | 1) + 3) >> 2;
+      break;
+#ifdef TINY_PRINTF_TIMESTAMP
+    case 'T':
+      // Fixed layout, only a missing struct timespec prints something else
+      len = TinyTimestampLength(op);
 #ifdef TINY_PRINTF_LONG_LONG
-        (options & FORMAT_LONG_LONG) ?
-          TinyPrintIntegerLongLong(printchar, ctx, va_arg(args, long long int), 10, 1, width, options, 'a') :
+      if(op->options & FORMAT_LONG_LONG) {
+        break;
+      }
 #endif
-          TinyPrintInteger(printchar, ctx, va_arg(args, int), 10, 1, width, options, 'a');
-        continue;
+      if(arg->p == NULL) {
+        len = sizeof("(null)") - 1;
       }
-      if(*format == 'x') {
-        pc +=
-#ifdef TINY_PRINTF_LONG_LONG
-        (options & FORMAT_LONG_LONG) ?
-          TinyPrintIntegerLongLong(printchar, ctx, va_arg(args, long long int), 16, 0, width, options, 'a') :
+      break;
 #endif
-          TinyPrintInteger(printchar, ctx, va_arg(args, int), 16, 0, width, options, 'a');
-        continue;
+    default:
+      // Floating point and registered conversions run into a sink discarding their output
+      return TINY_CONVERSION(op->specifier)->convert(TinyNullSpan, NULL, op, arg);
+  }
+
+  if(op->specifier == 'k') {
+    // Point and the zeros in front of fractions without integer digits
+    int scale = (op->options & FORMAT_PRECISION) ? op->precision : 0;
+    len = (len > scale) ? len + (scale > 0 || (op->options & FORMAT_ALT)) : scale + 2;
+  }
+  len += sign;
+  return (len < op->width) ? op->width : len;
+}
+
+/**********************************************************************************************************************/
+/** Compute the length of formatted output
+ ***********************************************************************************************************************
+ *
+ * Walks the format like TinyPrintfSpan() without producing any output.
+ *
+ * @returns number of bytes TinyPrintfSpan() would print (without terminating null character)
+ *
+ **********************************************************************************************************************/
+int TinyPrintfLength(
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  va_list args)
+{
+  TinyFormatOp op;
+  TinyFormatArg arg;
+  va_list ap;
+  int pc = 0;
+
+  va_copy(ap, args);
+
+#ifdef TINY_PRINTF_FORMAT_CACHE
+  {
+    const TinyFormat *compiled = TinyFormatCacheLookup(format);
+    if(compiled != NULL) {
+      const TinyFormatOp *cop = compiled->ops, *end = compiled->ops + compiled->count;
+      for(; cop != end; ++cop) {
+        pc += cop->literalLength;
+        if(cop->specifier != '\0') {
+          const TinyFormatOp *conversion = TinyFetchStars(cop, &op, &ap);
+          TinyFetchArg(conversion, &arg, &ap);
+          pc += TinyMeasure(conversion, &arg);
+        }
       }
-      if(*format == 'X') {
-        pc +=
-#ifdef TINY_PRINTF_LONG_LONG
-        (options & FORMAT_LONG_LONG) ?
-          TinyPrintIntegerLongLong(printchar, ctx, va_arg(args, long long int), 16, 0, width, options, 'A') :
+      va_end(ap);
+      return pc;
+    }
+  }
 #endif
-          TinyPrintInteger(printchar, ctx, va_arg(args, int), 16, 0, width, options, 'A');
+
+  while(*format != 0) {
+    if(*format == '%') {
+      if(format[1] != '%') {
+        format = TinyParseSpecifier(format + 1, &op);
+        TinyFetchStars(&op, &op, &ap);
+        TinyFetchArg(&op, &arg, &ap);
+        pc += TinyMeasure(&op, &arg);
         continue;
       }
-      if(*format == 'p') {
-        pc += TinyPrintInteger(printchar, ctx, va_arg(args, int), 16, 0, sizeof(void *) * 2, FORMAT_PAD_ZERO, 'A');
-        continue;
+      ++format;
+    }
+    {
+      const char *start = format;
+      for(++format; *format != '\0' && *format != '%'; ++format);
+      pc += format - start;
+    }
+  }
+
+  va_end(ap);
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Context for the TinySNPrintSpan() function
+ **********************************************************************************************************************/
+typedef struct {
+  /// Current string write pointer
+  char *string;
+  /// Number of bytes left in the string buffer
+  int length;
+} TinySNPrintSpanContext;
+
+/**********************************************************************************************************************/
+/** Put a span of bytes into sized buffer
+ **********************************************************************************************************************/
+static void TinySNPrintSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  // This will spare us a lots of casts.
+  TinySNPrintSpanContext *ctx = context;
+
+  // Do we still have space in the buffer left?
+  if(ctx->length <= 0) {
+    return;
+  }
+  // Only copy as much as fits
+  if(length > (size_t)ctx->length) {
+    length = ctx->length;
+  }
+  // Put characters into the string buffer
+  memcpy(ctx->string, string, length);
+  // Increment write pointer
+  ctx->string += length;
+  // Decrement space left
+  ctx->length -= (int)length;
+}
+
+/**********************************************************************************************************************/
+/** Write Integer Value Template
+ ***********************************************************************************************************************
+ *
+ * @param FUNC_NAME   - Name of the function
+ * @param INT_TYPE    - Type of the integer
+ * @param TO_DECIMAL  - Decimal conversion kernel for the unsigned type
+ * @param TO_HEX      - Hexadecimal conversion kernel for the unsigned type
+ *
+ * Same output as TINY_PRINT_INTEGER, but the digits are converted straight into the destination. Left padding moves
+ * the digits to their final place afterwards.
+ *
+ * @returns pointer after the last character written
+ *
+ **********************************************************************************************************************/
+#define TINY_WRITE_INTEGER(FUNC_NAME, INT_TYPE, TO_DECIMAL, TO_HEX)                                                    \
+static char *FUNC_NAME(                                                                                                \
+  /** [out] Destination, at least the width plus 21 characters */                                                      \
+  char *s,                                                                                                             \
+  /** [in] Integer to print */                                                                                         \
+  INT_TYPE i,                                                                                                          \
+  /** [in] Integer base to print (10 or 16) */                                                                         \
+  int b,                                                                                                               \
+  /** [in] Is integer signed? */                                                                                       \
+  int sg,                                                                                                              \
+  /** [in] Desired Width */                                                                                            \
+  int width,                                                                                                           \
+  /** [in] Formatting options */                                                                                       \
+  int options,                                                                                                         \
+  /** [in] Hexadecimal base character (lower / uppercase) */                                                           \
+  int letbase)                                                                                                         \
+{                                                                                                                      \
+  char *start = s;                                                                                                     \
+  int len, pad, padchar = (options & FORMAT_PAD_ZERO) ? '0' : ' ';                                                     \
+  char sign = 0;                                                                                                       \
+  unsigned INT_TYPE u = i;                                                                                             \
+                                                                                                                       \
+  if(sg && b == 10) {                                                                                                  \
+    if(i < 0) {                                                                                                        \
+      sign = '-';                                                                                                      \
+      u = -u;                                                                                                          \
+    }                                                                                                                  \
+    else if(options & FORMAT_PLUS) {                                                                                   \
+      sign = '+';                                                                                                      \
+    }                                                                                                                  \
+    else if(options & FORMAT_SPACE) {                                                                                  \
+      sign = ' ';                                                                                                      \
+    }                                                                                                                  \
+  }                                                                                                                    \
+                                                                                                                       \
+  if(sign) {                                                                                                           \
+    *s++ = sign;                                                                                                       \
+    /* Zero padding goes between the sign and the digits */                                                            \
+    if(width && (options & FORMAT_PAD_ZERO)) {                                                                         \
+      start = s;                                                                                                       \
+      --width;                                                                                                         \
+    }                                                                                                                  \
+  }                                                                                                                    \
+                                                                                                                       \
+  len = (int)(s - start) + ((b == 10) ? TO_DECIMAL(s, u) : TO_HEX(s, u, letbase));                                     \
+  pad = width - len;                                                                                                   \
+  if(pad <= 0) {                                                                                                       \
+    return start + len;                                                                                                \
+  }                                                                                                                    \
+                                                                                                                       \
+  if(options & FORMAT_PAD_RIGHT) {                                                                                     \
+    memset(start + len, padchar, pad);                                                                                 \
+  }                                                                                                                    \
+  else {                                                                                                               \
+    memmove(start + pad, start, len);                                                                                  \
+    memset(start, padchar, pad);                                                                                       \
+  }                                                                                                                    \
+                                                                                                                       \
+  return start + len + pad;                                                                                            \
+}
+
+/// Integer write function 32 bit version
+TINY_WRITE_INTEGER(TinyWriteInteger, int, TinyIntegerToDecimal, TinyIntegerToHex)
+
+#ifdef TINY_PRINTF_LONG_LONG
+/// Integer write function 64 bit version
+TINY_WRITE_INTEGER(TinyWriteIntegerLongLong, long long int, TinyLongLongToDecimal, TinyLongLongToHex)
+#endif
+
+/// Characters of the longest integer conversion without padding ("-9223372036854775808" plus one spare)
+#define TINY_WRITE_INTEGER_MAX 21
+
+/**********************************************************************************************************************/
+/** Print one conversion into a sized buffer
+ ***********************************************************************************************************************
+ *
+ * Integers are converted straight into the buffer when their widest possible output fits, strings are copied with a
+ * single bounds check. Everything else and conversions at the end of the buffer go through TinySNPrintSpan().
+ *
+ * @returns number of bytes the conversion produces (also the ones not fitting into the buffer)
+ *
+ **********************************************************************************************************************/
+static int TinySNConvert(
+  /// [in,out] Buffer context
+  TinySNPrintSpanContext *ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  char *end;
+  size_t len;
+
+  switch(op->specifier) {
+    case 'd':
+    case 'u':
+    case 'x':
+    case 'X':
+      if(ctx->length - op->width < TINY_WRITE_INTEGER_MAX) {
+        break;
       }
-      if(*format == 'u') {
-        pc +=
 #ifdef TINY_PRINTF_LONG_LONG
-        (options & FORMAT_LONG_LONG) ?
-          TinyPrintIntegerLongLong(printchar, ctx, va_arg(args, long long int), 10, 0, width, options, 'a') :
+      if(op->options & FORMAT_LONG_LONG) {
+        end = TinyWriteIntegerLongLong(ctx->string, arg->ll, (op->specifier == 'd' || op->specifier == 'u') ? 10 : 16,
+                                       op->specifier == 'd', op->width, op->options,
+                                       (op->specifier == 'X') ? 'A' : 'a');
+      }
+      else
 #endif
-          TinyPrintInteger(printchar, ctx, va_arg(args, int), 10, 0, width, options, 'a');
-        continue;
+      {
+        end = TinyWriteInteger(ctx->string, arg->i, (op->specifier == 'd' || op->specifier == 'u') ? 10 : 16,
+                               op->specifier == 'd', op->width, op->options, (op->specifier == 'X') ? 'A' : 'a');
       }
-#ifdef TINY_PRINTF_FLOAT
-      if(*format == 'f') {
-        pc += TinyPrintFloat(printchar, ctx, va_arg(args, double), precision);
-        continue;
+      len = end - ctx->string;
+      ctx->string = end;
+      ctx->length -= (int)len;
+      return (int)len;
+    case 's':
+      if(op->width != 0) {
+        break;
       }
+      len = TinyStringLength(arg->s ? arg->s : "(null)", op);
+      TinySNPrintSpan(ctx, arg->s ? arg->s : "(null)", len);
+      return (int)len;
+  }
+
+  // Counted by the caller together with the direct conversions
+  return TINY_CONVERSION(op->specifier)->convert(TinySNPrintSpan, ctx, op, arg);
+}
+
+/**********************************************************************************************************************/
+/** Print one conversion into a sized buffer and count it in the statistics
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes the conversion produces (also the ones not fitting into the buffer)
+ *
+ **********************************************************************************************************************/
+static int TinySNConversion(
+  /// [in,out] Buffer context
+  TinySNPrintSpanContext *ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+#ifdef TINY_PRINTF_STATS
+  unsigned long long int start = TINY_PRINTF_STATS_CLOCK();
+  int len = TinySNConvert(ctx, op, arg);
+
+  TinyStatsConversion(op, len, start);
+  return len;
+#else
+  return TinySNConvert(ctx, op, arg);
 #endif
-      if(*format == 'c') {
-        // This works with any byte, even with zero
-        if(width <= 1) {
-          printchar(ctx, (char)va_arg(args, int));
-          ++pc;
+}
+
+/**********************************************************************************************************************/
+/** Write formatted output to sized buffer without counting the call in the statistics
+ ***********************************************************************************************************************
+ *
+ * Buffer writing engine of the snprintf family: literal runs are found with memchr() and copied with memcpy(), integers
+ * are converted straight into the buffer and the remaining space is checked once per span, not per character.
+ *
+ * @returns number of characters the output has (also the ones not fitting into the buffer), without null character
+ *
+ **********************************************************************************************************************/
+static int TinySNFormat(
+  /// [in] String to print into
+  char *string,
+  /// [in] Maximum number of bytes to be used in the buffer, including the terminating null character (at least 1)
+  int length,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  va_list args,
+  /// [in] Count the conversions in the statistics
+  int count)
+{
+  TinySNPrintSpanContext context;
+  TinyFormatOp op;
+  TinyFormatArg arg;
+  const char *end, *next;
+  va_list ap;
+  int pc = 0;
+
+  // Reserve space for the terminating null character
+  context.string = string;
+  context.length = length - 1;
+  end = NULL;
+
+  va_copy(ap, args);
+
+#ifdef TINY_PRINTF_FORMAT_CACHE
+  {
+    const TinyFormat *compiled = TinyFormatCacheLookup(fmt);
+    if(compiled != NULL) {
+      const TinyFormatOp *cop = compiled->ops, *last = compiled->ops + compiled->count;
+      for(; cop != last; ++cop) {
+        if(cop->literalLength != 0) {
+          TinySNPrintSpan(&context, cop->literal, cop->literalLength);
+          pc += cop->literalLength;
         }
-        // This works with width, but not with zero byte
-        else {
-          // chars are converted to int then pushed on the stack
-          char scr[2];
-          scr[0] = (char)va_arg(args, int);
-          scr[1] = '\0';
-          pc += TinyPrintString(printchar, ctx, scr, width, options);
+        if(cop->specifier != '\0') {
+          const TinyFormatOp *conversion = TinyFetchStars(cop, &op, &ap);
+          TinyFetchArg(conversion, &arg, &ap);
+          pc += count ? TinySNConversion(&context, conversion, &arg) : TinySNConvert(&context, conversion, &arg);
         }
-        continue;
       }
+      // Nothing left for the parser below
+      end = fmt;
     }
-    else {
-      out:
-      printchar(ctx, *format);
+  }
+#endif
+  if(end == NULL) {
+    end = fmt + strlen(fmt);
+  }
+
+  while(fmt != end) {
+    // Copy the literal run up to the next format specifier at once
+    next = memchr(fmt, '%', end - fmt);
+    if(next == NULL) {
+      next = end;
+    }
+    if(next != fmt) {
+      TinySNPrintSpan(&context, fmt, next - fmt);
+      pc += next - fmt;
+      fmt = next;
+      continue;
+    }
+    // "%%" prints a '%' and starts the next literal run
+    if(fmt[1] == '%') {
+      TinySNPrintSpan(&context, fmt, 1);
       ++pc;
+      fmt += 2;
+      continue;
     }
+    fmt = TinyParseSpecifier(fmt + 1, &op);
+    TinyFetchStars(&op, &op, &ap);
+    TinyFetchArg(&op, &arg, &ap);
+    pc += count ? TinySNConversion(&context, &op, &arg) : TinySNConvert(&context, &op, &arg);
   }
 
+  va_end(ap);
+
+  *context.string = '\0';
+
   return pc;
 }
 
 /**********************************************************************************************************************/
-/** Context for the TinySNPrintChar() function
- **********************************************************************************************************************/
-typedef struct {
-  /// Current string write pointer
-  char *string;
-  /// Number of bytes left in the string buffer
-  int length;
-} TinySNPrintCharContext;
-
-/**********************************************************************************************************************/
-/** Put one byte into sized buffer
+/** Write formatted output to sized buffer
+ ***********************************************************************************************************************
+ *
+ * If the resulting string would be longer than length-1 characters, the remaining characters are discarded and not
+ * stored, but counted for the value returned by the function. A terminating null character is appended. Without a
+ * buffer (length <= 0) only the length is computed.
+ *
+ * @returns
+ * The number of characters that would have been written if length had been sufficiently large, not counting the
+ * terminating null character.
+ *
  **********************************************************************************************************************/
-static void TinySNPrintChar(
-  /// [in] Pointer to the context
-  void *context,
-  /// [in] Character to print
-  char c)
+int TinyVSNprintf(
+  /// [in] String to print into
+  char *string,
+  /// [in] Maximum number of bytes to be used in the buffer, including the terminating null character
+  int length,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  va_list args)
 {
-  // This will spare us a lots of casts.
-  TinySNPrintCharContext *ctx = context;
+#ifdef TINY_PRINTF_STATS
+  unsigned long long int start = TINY_PRINTF_STATS_CLOCK();
+#endif
+  int pc;
 
-  // Do we still have space in the buffer left?
-  if(ctx->length != 0) {
-    // Put character into the string buffer
-    *(ctx->string) = c;
-    // Increment write pointer
-    (ctx->string)++;
-    // Decrement space left
-    (ctx->length)--;
+  // Without a buffer only the length is needed
+  if(length <= 0) {
+    return TinyPrintfLength(fmt, args);
+  }
+
+  pc = TinySNFormat(string, length, fmt, args, 1);
+
+#ifdef TINY_PRINTF_STATS
+  if(pc >= length) {
+    TinyStatsShard *shard = TinyStatsGetShard();
+    TINY_STATS_COUNT(shard, &shard->truncations, 1);
   }
+  TinyStatsCall(fmt, pc, start);
+#endif
+
+  return pc;
 }
 
 /**********************************************************************************************************************/
@@ -441,27 +4446,454 @@ int TinySNprintf(
   /// [in] Format arguments
   ...)
 {
-  // printchar context
-  TinySNPrintCharContext context;
   // Return value
   int ret;
   // additional parameters
   va_list va;
 
-  // We store the string starting address
-  context.string = string;
-  // And the maximum length (we reserve space for the terminating null character)
-  context.length = length - 1;
+  va_start(va, fmt);
+  ret = TinyVSNprintf(string, length, fmt, va);
+  va_end(va);
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Write formatted output to a newly allocated string
+ ***********************************************************************************************************************
+ *
+ * The length is computed first with TinyPrintfLength(), so the string is allocated exactly once and formatted by the
+ * buffer writing engine of TinyVSNprintf(). The caller releases it with reallocate(allocCtx, string, 0).
+ *
+ * @returns number of characters written (not counting the terminating null character) or -1 if the allocation failed
+ *
+ **********************************************************************************************************************/
+int TinyVASprintf(
+  /// [out] Allocated string (NULL if the allocation failed)
+  char **string,
+  /// [in] Allocator function
+  reallocate_t reallocate,
+  /// [in] context for the allocator function
+  void *allocCtx,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  va_list args)
+{
+  int length = TinyPrintfLength(fmt, args);
+
+  *string = reallocate(allocCtx, NULL, (size_t)length + 1);
+  if(*string == NULL) {
+    return -1;
+  }
+
+  return TinyVSNprintf(*string, length + 1, fmt, args);
+}
+
+/**********************************************************************************************************************/
+/** Write formatted output to a newly allocated string
+ ***********************************************************************************************************************
+ *
+ * @returns number of characters written (not counting the terminating null character) or -1 if the allocation failed
+ *
+ **********************************************************************************************************************/
+int TinyASprintf(
+  /// [out] Allocated string (NULL if the allocation failed)
+  char **string,
+  /// [in] Allocator function
+  reallocate_t reallocate,
+  /// [in] context for the allocator function
+  void *allocCtx,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int ret;
+
+  va_start(va, fmt);
+  ret = TinyVASprintf(string, reallocate, allocCtx, fmt, va);
+  va_end(va);
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Initialize a growable string
+ ***********************************************************************************************************************
+ *
+ * Nothing is allocated until the first append.
+ *
+ **********************************************************************************************************************/
+void TinyBuilderInit(
+  /// [out] Builder
+  TinyBuilder *builder,
+  /// [in] Allocator function
+  reallocate_t reallocate,
+  /// [in] context for the allocator function
+  void *allocCtx)
+{
+  builder->string = NULL;
+  builder->length = 0;
+  builder->size = 0;
+  builder->reallocate = reallocate;
+  builder->allocCtx = allocCtx;
+  builder->error = 0;
+}
+
+/**********************************************************************************************************************/
+/** Make room for appending to a growable string
+ ***********************************************************************************************************************
+ *
+ * The memory at least doubles when it grows, so appending costs amortized constant time per character.
+ *
+ * @returns 0 on success, -1 if the allocation failed now or since the last TinyBuilderReset()
+ *
+ **********************************************************************************************************************/
+int TinyBuilderReserve(
+  /// [in,out] Builder
+  TinyBuilder *builder,
+  /// [in] Number of characters to be appended
+  size_t length)
+{
+  size_t need = builder->length + length + 1, size = builder->size;
+  char *string;
+
+  // After a failed grow nothing is appended, not even what would still fit
+  if(builder->error) {
+    return -1;
+  }
+  if(need <= size) {
+    return 0;
+  }
+  for(size = size ? size * 2 : TINY_PRINTF_BUILDER_SIZE; size < need; size *= 2);
+  string = builder->reallocate(builder->allocCtx, builder->string, size);
+  if(string == NULL) {
+    builder->error = 1;
+    return -1;
+  }
+  builder->string = string;
+  builder->size = size;
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Append a span of characters to a growable string
+ ***********************************************************************************************************************
+ *
+ * printspan_t function taking a TinyBuilder as context, e.g. for TinyPrintfSpan() and TinyFormatExec().
+ *
+ **********************************************************************************************************************/
+void TinyBuilderSpan(
+  /// [in] Pointer to the builder
+  void *builder,
+  /// [in] Characters to append
+  const char *string,
+  /// [in] Number of characters to append
+  size_t length)
+{
+  TinyBuilder *ctx = builder;
+
+  if(ctx->error || TinyBuilderReserve(ctx, length) != 0) {
+    return;
+  }
+  memcpy(ctx->string + ctx->length, string, length);
+  ctx->length += length;
+  ctx->string[ctx->length] = '\0';
+}
+
+/**********************************************************************************************************************/
+/** Append formatted output to a growable string
+ ***********************************************************************************************************************
+ *
+ * The output is written by the buffer writing engine of TinyVSNprintf() into the free space. If it does not fit, the
+ * string grows once to the measured length and the output is written again, so the string never grows per character
+ * or per conversion.
+ *
+ * @returns number of characters appended or -1 if the allocation failed
+ *
+ **********************************************************************************************************************/
+int TinyBuilderVPrintf(
+  /// [in,out] Builder
+  TinyBuilder *builder,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  va_list args)
+{
+#ifdef TINY_PRINTF_STATS
+  unsigned long long int start = TINY_PRINTF_STATS_CLOCK();
+#endif
+  size_t space;
+  va_list ap;
+  int pc;
+
+  // Also allocates the first memory, so there is always space for the null character
+  if(TinyBuilderReserve(builder, 0) != 0) {
+    return -1;
+  }
+  space = builder->size - builder->length;
+  va_copy(ap, args);
+  pc = TinySNFormat(builder->string + builder->length, space < INT_MAX ? (int)space : INT_MAX, fmt, ap, 1);
+  va_end(ap);
+
+  if((size_t)pc >= space) {
+    if(TinyBuilderReserve(builder, pc) != 0) {
+      // Drop the part that did fit
+      builder->string[builder->length] = '\0';
+      return -1;
+    }
+    // The conversions were counted by the first pass
+    TinySNFormat(builder->string + builder->length, pc + 1, fmt, args, 0);
+  }
+  builder->length += pc;
+
+#ifdef TINY_PRINTF_STATS
+  // One call, without truncation
+  TinyStatsCall(fmt, pc, start);
+#endif
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Append formatted output to a growable string
+ ***********************************************************************************************************************
+ *
+ * @returns number of characters appended or -1 if the allocation failed
+ *
+ **********************************************************************************************************************/
+int TinyBuilderPrintf(
+  /// [in,out] Builder
+  TinyBuilder *builder,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int ret;
 
-  // Do the formatted printing
   va_start(va, fmt);
-  ret = TinyPrintf(TinySNPrintChar, &context, fmt, va);
+  ret = TinyBuilderVPrintf(builder, fmt, va);
   va_end(va);
 
-  // Now we free up the reserved space for the the terminating null character
-  context.length++;
-  // And put it also into the string
-  TinySNPrintChar(&context, '\0');
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Empty a growable string for reuse
+ ***********************************************************************************************************************
+ *
+ * The memory is kept, so a builder reused for many messages stops allocating once it reached the size of the longest.
+ *
+ **********************************************************************************************************************/
+void TinyBuilderReset(
+  /// [in,out] Builder
+  TinyBuilder *builder)
+{
+  builder->length = 0;
+  builder->error = 0;
+  if(builder->string != NULL) {
+    builder->string[0] = '\0';
+  }
+}
+
+/**********************************************************************************************************************/
+/** Release the memory of a growable string
+ **********************************************************************************************************************/
+void TinyBuilderFree(
+  /// [in,out] Builder
+  TinyBuilder *builder)
+{
+  if(builder->string != NULL) {
+    builder->reallocate(builder->allocCtx, builder->string, 0);
+  }
+  TinyBuilderInit(builder, builder->reallocate, builder->allocCtx);
+}
+
+#ifdef TINY_PRINTF_STATS
+/**********************************************************************************************************************/
+/** Add a statistics counter to a snapshot
+ **********************************************************************************************************************/
+static void TinyStatsSum(
+  /// [in,out] Sum
+  TinyStatsCounter *sum,
+  /// [in] Counter
+  TinyStatsCounter *counter)
+{
+  sum->count += TINY_STATS_LOAD(&counter->count);
+  sum->bytes += TINY_STATS_LOAD(&counter->bytes);
+  sum->ticks += TINY_STATS_LOAD(&counter->ticks);
+}
+
+/**********************************************************************************************************************/
+/** Clear a statistics counter
+ **********************************************************************************************************************/
+static void TinyStatsClear(
+  /// [out] Counter
+  TinyStatsCounter *counter)
+{
+  TINY_STATS_STORE(&counter->count, 0);
+  TINY_STATS_STORE(&counter->bytes, 0);
+  TINY_STATS_STORE(&counter->ticks, 0);
+}
+
+/**********************************************************************************************************************/
+/** Take a snapshot of the formatting statistics
+ ***********************************************************************************************************************
+ *
+ * Sums up the counters of all threads. They are read one by one while other threads keep counting, so they need not
+ * be consistent with each other.
+ *
+ **********************************************************************************************************************/
+void TinyStatsSnapshot(
+  /// [out] Statistics
+  TinyStats *stats)
+{
+  TinyStatsShard *shard;
+  int i;
+
+  memset(stats, 0, sizeof(*stats));
+  for(i = 0; i < TINY_PRINTF_STATS_FORMATS; i++) {
+    int c;
+    stats->formats[i].format = TINY_STATS_LOAD(&tinyStatsFormats[i]);
+    if(__atomic_load_n(&tinyStatsFormatCopied[i], __ATOMIC_ACQUIRE)) {
+      for(c = 0; c < TINY_PRINTF_STATS_FORMAT_TEXT - 1; c++) {
+        stats->formats[i].text[c] = TINY_STATS_LOAD(&tinyStatsFormatTexts[i][c]);
+      }
+    }
+  }
+  for(shard = tinyStatsShards; shard != tinyStatsShards + TINY_PRINTF_STATS_SHARDS; shard++) {
+    TinyStatsSum(&stats->calls, &shard->calls);
+    stats->truncations += TINY_STATS_LOAD(&shard->truncations);
+    for(i = 0; i < 256; i++) {
+      TinyStatsSum(&stats->conversions[i], &shard->conversions[i]);
+    }
+    for(i = 0; i < TINY_PRINTF_STATS_FORMATS; i++) {
+      TinyStatsSum(&stats->formats[i].calls, &shard->formats[i]);
+    }
+    TinyStatsSum(&stats->otherFormats, &shard->otherFormats);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Reset the formatting statistics
+ ***********************************************************************************************************************
+ *
+ * Counts of calls running in other threads at the same time may be lost.
+ *
+ **********************************************************************************************************************/
+void TinyStatsReset(void)
+{
+  const char *none = NULL;
+  TinyStatsShard *shard;
+  int i;
+
+  for(shard = tinyStatsShards; shard != tinyStatsShards + TINY_PRINTF_STATS_SHARDS; shard++) {
+    TinyStatsClear(&shard->calls);
+    TINY_STATS_STORE(&shard->truncations, 0);
+    for(i = 0; i < 256; i++) {
+      TinyStatsClear(&shard->conversions[i]);
+    }
+    for(i = 0; i < TINY_PRINTF_STATS_FORMATS; i++) {
+      TinyStatsClear(&shard->formats[i]);
+    }
+    TinyStatsClear(&shard->otherFormats);
+  }
+  for(i = 0; i < TINY_PRINTF_STATS_FORMATS; i++) {
+    TINY_STATS_STORE(&tinyStatsFormatCopied[i], 0);
+    TINY_STATS_STORE(&tinyStatsFormats[i], none);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Print formatted output for TinyStatsDump()
+ **********************************************************************************************************************/
+static int TinyStatsPrint(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Format string
+  const char *fmt,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int ret;
+
+  va_start(va, fmt);
+  ret = TinyPrintfSpan(printspan, ctx, fmt, va);
+  va_end(va);
 
   return ret;
 }
+
+/**********************************************************************************************************************/
+/** Print one line of statistics
+ **********************************************************************************************************************/
+static int TinyStatsPrintCounter(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Counter
+  const TinyStatsCounter *counter)
+{
+  return TinyStatsPrint(printspan, ctx, " %12llu %14llu %16llu %10llu\n", counter->count, counter->bytes,
+                        counter->ticks, counter->ticks / counter->count);
+}
+
+/**********************************************************************************************************************/
+/** Print formatting statistics
+ ***********************************************************************************************************************
+ *
+ * Prints a table of the calls, the conversions by specifier and the calls by format string (up to the first line
+ * break), leaving out unused entries. Printing a snapshot keeps the table consistent with itself; the lines printed are
+ * counted in the live statistics.
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+int TinyStatsDump(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Statistics (see TinyStatsSnapshot())
+  const TinyStats *stats)
+{
+  int i, pc;
+
+  pc = TinyStatsPrint(printspan, ctx, "%-24s %12s %14s %16s %10s\n", "", "count", "bytes", "ticks", "ticks/each");
+  if(stats->calls.count != 0) {
+    pc += TinyStatsPrint(printspan, ctx, "%-24s", "calls");
+    pc += TinyStatsPrintCounter(printspan, ctx, &stats->calls);
+  }
+  pc += TinyStatsPrint(printspan, ctx, "%-24s %12llu\n", "truncations", stats->truncations);
+  for(i = 0; i < 256; i++) {
+    if(stats->conversions[i].count != 0) {
+      pc += TinyStatsPrint(printspan, ctx, "conversion %%%-12c", i);
+      pc += TinyStatsPrintCounter(printspan, ctx, &stats->conversions[i]);
+    }
+  }
+  for(i = 0; i < TINY_PRINTF_STATS_FORMATS; i++) {
+    const char *format = stats->formats[i].format;
+    if(format != NULL && stats->formats[i].calls.count != 0) {
+      // Only the copy is printed, the format string itself may be gone
+      pc += TinyStatsPrint(printspan, ctx, "format %p%*s", format, (int)(17 - 2 * sizeof(void *)), "");
+      pc += TinyStatsPrintCounter(printspan, ctx, &stats->formats[i].calls);
+      pc += TinyStatsPrint(printspan, ctx, "  \"%s\"\n", stats->formats[i].text);
+    }
+  }
+  if(stats->otherFormats.count != 0) {
+    pc += TinyStatsPrint(printspan, ctx, "%-24s", "other formats");
+    pc += TinyStatsPrintCounter(printspan, ctx, &stats->otherFormats);
+  }
+
+  return pc;
+}
+#endif
@@ -21,7 +21,8 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
- * All functions are thread safe.
+ * All functions are thread safe, except TinyFormatRegister(): registration must finish before formatting starts on
+ * other threads.
  *
  * @file tiny_printf.h
  *
@@ -31,6 +32,7 @@
 #define TINY_PRINTF_H_
 
 #include <stdarg.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,9 +40,274 @@ extern "C" {
 
 /// printchar function type
 typedef void (*printchar_t)(void *, char);
+/// printspan function type (context, characters, number of characters)
+typedef void (*printspan_t)(void *, const char *, size_t);
+/// Allocator function type in the style of realloc() (context, pointer or NULL, new size or 0 to free)
+typedef void *(*reallocate_t)(void *, void *, size_t);
+
+/// Formatting option: pad to the right
+#define TINY_FORMAT_PAD_RIGHT  (1 << 0)
+/// Formatting option: pad with zeros
+#define TINY_FORMAT_PAD_ZERO   (1 << 1)
+/// Formatting option: format as long long
+#define TINY_FORMAT_LONG_LONG  (1 << 2)
+/// Formatting option: always print the sign of signed conversions
+#define TINY_FORMAT_PLUS       (1 << 3)
+/// Formatting option: print a space in place of a plus sign
+#define TINY_FORMAT_SPACE      (1 << 4)
+/// Formatting option: alternative form (always print the decimal point of floating point conversions)
+#define TINY_FORMAT_ALT        (1 << 5)
+/// Formatting option: precision given in the format
+#define TINY_FORMAT_PRECISION  (1 << 6)
+/// Width or precision taken from the arguments ('*'), consumed as TINY_ARG_INT in front of the conversion's argument
+#define TINY_FORMAT_STAR       (-1)
+
+/// Operation of a compiled format: literal text followed by an optional conversion
+typedef struct {
+  /// Literal text printed before the conversion (points into the format string)
+  const char *literal;
+  /// Length of the literal text
+  int literalLength;
+  /// Conversion specifier character, '\0' if the operation consists of literal text only
+  char specifier;
+  /// Formatting options (TINY_FORMAT_*)
+  unsigned char options;
+  /// Desired width (TINY_FORMAT_STAR if taken from the arguments)
+  int width;
+  /// Precision (TINY_FORMAT_STAR if taken from the arguments, after the width)
+  int precision;
+  /// Conversion modifier (separator of hex dumps), '\0' if none
+  char modifier;
+} TinyFormatOp;
+
+/// Argument types consumed by conversions
+typedef enum {
+  /// No argument
+  TINY_ARG_NONE,
+  /// int (also char)
+  TINY_ARG_INT,
+  /// long long int
+  TINY_ARG_LONG_LONG,
+  /// double
+  TINY_ARG_DOUBLE,
+  /// const char *
+  TINY_ARG_STRING,
+  /// const void *
+  TINY_ARG_POINTER
+} TinyFormatArgType;
+
+/// Argument of one conversion
+typedef union {
+  /// TINY_ARG_INT
+  int i;
+  /// TINY_ARG_LONG_LONG
+  long long int ll;
+  /// TINY_ARG_DOUBLE
+  double f;
+  /// TINY_ARG_STRING
+  const char *s;
+  /// TINY_ARG_POINTER
+  const void *p;
+} TinyFormatArg;
+
+/// Conversion function type (printspan function, context, conversion, argument), returns number of bytes printed
+typedef int (*convert_t)(printspan_t, void *, const TinyFormatOp *, const TinyFormatArg *);
+
+/// Field types of batch records
+typedef enum {
+  /// signed char
+  TINY_FIELD_CHAR,
+  /// unsigned char
+  TINY_FIELD_UCHAR,
+  /// short int
+  TINY_FIELD_SHORT,
+  /// unsigned short int
+  TINY_FIELD_USHORT,
+  /// int
+  TINY_FIELD_INT,
+  /// unsigned int
+  TINY_FIELD_UINT,
+  /// long long int
+  TINY_FIELD_LONG_LONG,
+  /// unsigned long long int
+  TINY_FIELD_ULONG_LONG,
+  /// float
+  TINY_FIELD_FLOAT,
+  /// double
+  TINY_FIELD_DOUBLE,
+  /// const char * (pointer member)
+  TINY_FIELD_STRING,
+  /// char[] (null terminated array member)
+  TINY_FIELD_CHARS,
+  /// const void *
+  TINY_FIELD_POINTER
+} TinyFormatFieldType;
+
+/// Field of a batch record consumed by one conversion
+typedef struct {
+  /// Offset of the field in the record (offsetof())
+  size_t offset;
+  /// Type of the field
+  TinyFormatFieldType type;
+} TinyFormatField;
+
+/// Compiled format
+typedef struct {
+  /// Operations
+  TinyFormatOp *ops;
+  /// Number of operations
+  int count;
+} TinyFormat;
+
+/// Characters of a conversion TinyFormatStep() keeps between steps (runs of one character and strings take none)
+#ifndef TINY_PRINTF_STEP_TEXT
+#define TINY_PRINTF_STEP_TEXT 64
+#endif
+/// Pieces of a conversion TinyFormatStep() keeps between steps
+#ifndef TINY_PRINTF_STEP_PIECES
+#define TINY_PRINTF_STEP_PIECES 6
+#endif
+
+/// Piece of the output of a conversion kept by TinyFormatStep()
+typedef struct {
+  /// Characters of a string argument or a constant, NULL for characters in the text of the state or for a run
+  const char *string;
+  /// Number of characters
+  size_t length;
+  /// Character repeated length times, -1 if this is no run
+  int run;
+} TinyFormatPiece;
+
+/// State of an incremental formatting, see TinyFormatStart() and TinyFormatStep()
+typedef struct {
+  /// Compiled format
+  const TinyFormat *compiled;
+  /// Arguments of the current and the following operations
+  const TinyFormatArg *args;
+  /// Current operation
+  int op;
+  /// Bytes of the current operation already delivered
+  size_t offset;
+  /// The current conversion has output beyond the kept pieces
+  int more;
+  /// Bytes of a hex dump converted so far
+  int dumped;
+  /// Number of kept pieces
+  int pieceCount;
+  /// Piece delivered next
+  int piece;
+  /// Bytes of that piece already delivered
+  size_t pieceOffset;
+  /// Start of the characters of that piece in the text
+  int textOffset;
+  /// Kept pieces of the current conversion
+  TinyFormatPiece pieces[TINY_PRINTF_STEP_PIECES];
+  /// Characters of the pieces without string or run
+  char text[TINY_PRINTF_STEP_TEXT];
+} TinyFormatState;
+
+/// Growable string, see TinyBuilderInit()
+typedef struct {
+  /// Null terminated contents (NULL until something was appended)
+  char *string;
+  /// Number of characters appended (not counting the terminating null character)
+  size_t length;
+  /// Size of the allocated memory
+  size_t size;
+  /// Allocator function
+  reallocate_t reallocate;
+  /// context for the allocator function
+  void *allocCtx;
+  /// Set when growing failed, everything appended afterwards is dropped until the next TinyBuilderReset()
+  int error;
+} TinyBuilder;
+
+#ifdef TINY_PRINTF_STATS
+/// Number of format strings with their own statistics, further formats are summed up
+#ifndef TINY_PRINTF_STATS_FORMATS
+#define TINY_PRINTF_STATS_FORMATS 64
+#endif
+/// Size of the copy of a format string kept for TinyStatsDump(), including the null character
+#ifndef TINY_PRINTF_STATS_FORMAT_TEXT
+#define TINY_PRINTF_STATS_FORMAT_TEXT 48
+#endif
+
+/// Statistics counter
+typedef struct {
+  /// Number of calls or conversions
+  unsigned long long int count;
+  /// Number of bytes produced (also the ones not fitting into the buffer)
+  unsigned long long int bytes;
+  /// Time spent (TSC cycles on x86, nanoseconds elsewhere)
+  unsigned long long int ticks;
+} TinyStatsCounter;
+
+/// Statistics of one format string
+typedef struct {
+  /// Address of the format string, NULL for an unused entry (identifies the format, may no longer be valid)
+  const char *format;
+  /// Start of the format string up to the first newline, copied when the entry was taken
+  char text[TINY_PRINTF_STATS_FORMAT_TEXT];
+  /// Calls using the format
+  TinyStatsCounter calls;
+} TinyStatsFormat;
+
+/// Formatting statistics
+typedef struct {
+  /// printf calls
+  TinyStatsCounter calls;
+  /// TinySNprintf() calls truncating their output
+  unsigned long long int truncations;
+  /// Conversions by specifier character
+  TinyStatsCounter conversions[256];
+  /// Calls by format string
+  TinyStatsFormat formats[TINY_PRINTF_STATS_FORMATS];
+  /// Calls with format strings not fitting into formats
+  TinyStatsCounter otherFormats;
+} TinyStats;
+#endif
 
 int TinyPrintf(printchar_t printchar, void* ctx, const char *format, va_list args);
+int TinyPrintfSpan(printspan_t printspan, void* ctx, const char *format, va_list args);
 int TinySNprintf(char* s, int, const char *fmt, ...);
+int TinyVSNprintf(char *string, int length, const char *fmt, va_list args);
+int TinyPrintfLength(const char *format, va_list args);
+int TinyVASprintf(char **string, reallocate_t reallocate, void *allocCtx, const char *fmt, va_list args);
+int TinyASprintf(char **string, reallocate_t reallocate, void *allocCtx, const char *fmt, ...);
+void TinyBuilderInit(TinyBuilder *builder, reallocate_t reallocate, void *allocCtx);
+int TinyBuilderReserve(TinyBuilder *builder, size_t length);
+void TinyBuilderSpan(void *builder, const char *string, size_t length);
+int TinyBuilderVPrintf(TinyBuilder *builder, const char *fmt, va_list args);
+int TinyBuilderPrintf(TinyBuilder *builder, const char *fmt, ...);
+void TinyBuilderReset(TinyBuilder *builder);
+void TinyBuilderFree(TinyBuilder *builder);
+int TinyFormatCompile(TinyFormat *compiled, TinyFormatOp *ops, int maxOps, const char *format);
+int TinyFormatExec(const TinyFormat *compiled, printspan_t printspan, void* ctx, va_list args);
+int TinyFormatExecArgs(const TinyFormat *compiled, printspan_t printspan, void* ctx, const TinyFormatArg *args);
+int TinyFormatFetchArgs(const TinyFormat *compiled, TinyFormatArg *fetched, int maxArgs, va_list args);
+void TinyFormatStart(TinyFormatState *state, const TinyFormat *compiled, const TinyFormatArg *args);
+size_t TinyFormatStep(TinyFormatState *state, char *buffer, size_t length);
+TinyFormatArgType TinyFormatGetArgType(const TinyFormatOp *op);
+int TinyFormatGetArgCount(const TinyFormatOp *op);
+int TinyFormatRegister(char specifier, TinyFormatArgType type, convert_t convert);
+int TinyFormatConvert(printspan_t printspan, void* ctx, const TinyFormatOp *op, const TinyFormatArg *arg);
+int TinyFormatBatch(const TinyFormat *compiled, const TinyFormatField *fields, const void *records, size_t stride,
+                    int count, char *buf, size_t size, size_t *offsets);
+int TinyFormatPadded(printspan_t printspan, void* ctx, const char *string, int len, int width, int options);
+int TinyFormatInteger(printspan_t printspan, void* ctx, int i, int b, int sg, int width, int options, int letbase);
+#ifdef TINY_PRINTF_LONG_LONG
+int TinyFormatIntegerLongLong(printspan_t printspan, void* ctx, long long int i, int b, int sg, int width, int options,
+                              int letbase);
+#endif
+int TinyFormatHexDump(printspan_t printspan, void* ctx, const void *data, int length, const TinyFormatOp *op);
+#ifdef TINY_PRINTF_FLOAT
+int TinyFormatFloat(printspan_t printspan, void* ctx, double number, const TinyFormatOp *op);
+#endif
+#ifdef TINY_PRINTF_STATS
+void TinyStatsSnapshot(TinyStats *stats);
+void TinyStatsReset(void);
+int TinyStatsDump(printspan_t printspan, void* ctx, const TinyStats *stats);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,760 @@
+/**********************************************************************************************************************/
+/** Compile time specialized C++ front end for the minimal printf implementation
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The format string is a template argument, it is parsed and checked against the argument types at compile time:
+ *
+ *   tiny::SNprintf<"%s:%d id=%08x\n">(buf, sizeof(buf), file, line, id);
+ *
+ * Each conversion calls its kernel in tiny_printf.c directly, without va_list or specifier dispatch at run time.
+ * Requires C++20 (class type template parameters). The TINY_PRINTF_* macros have to match the ones tiny_printf.c was
+ * built with.
+ *
+ * @file tiny_printf.hpp
+ *
+ **********************************************************************************************************************/
+
+#ifndef TINY_PRINTF_HPP_
+#define TINY_PRINTF_HPP_
+
+#include "tiny_printf.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace tiny {
+
+/**********************************************************************************************************************/
+/** Format string usable as template argument
+ **********************************************************************************************************************/
+template<std::size_t N>
+struct FormatString {
+  /// Characters including the terminating null character
+  char data[N];
+
+  /// Construct from a string literal
+  constexpr FormatString(
+    /// [in] String literal
+    const char (&string)[N])
+  {
+    for(std::size_t i = 0; i < N; i++) {
+      data[i] = string[i];
+    }
+  }
+};
+
+/**********************************************************************************************************************/
+/** Argument type of a conversion registered with TinyFormatRegister()
+ ***********************************************************************************************************************
+ *
+ * Specialize for the specifier of each registered conversion, before the first format using it:
+ *
+ *   template<> struct tiny::CustomConversion<'I'> { static constexpr TinyFormatArgType type = TINY_ARG_INT; };
+ *
+ **********************************************************************************************************************/
+template<char C>
+struct CustomConversion {
+  /// Type of the argument the conversion consumes, TINY_ARG_NONE for specifiers without a conversion
+  static constexpr TinyFormatArgType type = TINY_ARG_NONE;
+};
+
+namespace detail {
+
+/// Operation of a compile time parsed format, the literal text is an offset into the format string
+struct Op {
+  /// Offset of the literal text
+  std::size_t literal;
+  /// Length of the literal text
+  int literalLength;
+  /// Conversion specifier character, '\0' if the operation consists of literal text only
+  char specifier;
+  /// Formatting options (TINY_FORMAT_*)
+  unsigned char options;
+  /// Desired width (TINY_FORMAT_STAR if taken from the arguments)
+  int width;
+  /// Precision
+  int precision;
+  /// Conversion modifier (separator of hex dumps), '\0' if none
+  char modifier;
+};
+
+/**********************************************************************************************************************/
+/** Get the argument type of a registered conversion
+ **********************************************************************************************************************/
+template<std::size_t... C>
+constexpr TinyFormatArgType CustomArgType(
+  /// [in] Specifier character
+  char specifier,
+  /// [in] All specifier characters
+  std::index_sequence<C...>)
+{
+  TinyFormatArgType type = TINY_ARG_NONE;
+  ((static_cast<unsigned char>(specifier) == C ? (type = CustomConversion<static_cast<char>(C)>::type) : type), ...);
+  return type;
+}
+
+/**********************************************************************************************************************/
+/** Get the argument type of a conversion, same as TinyFormatGetArgType()
+ ***********************************************************************************************************************
+ *
+ * Template, so the CustomConversion specializations are looked up where a format is used, not where this is defined.
+ *
+ **********************************************************************************************************************/
+template<int = 0>
+constexpr TinyFormatArgType ArgType(
+  /// [in] Conversion
+  const Op &op)
+{
+  TinyFormatArgType type;
+
+  switch(op.specifier) {
+    case 's':
+      return TINY_ARG_STRING;
+    case 'd':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'k':
+#ifdef TINY_PRINTF_LONG_LONG
+      if(op.options & TINY_FORMAT_LONG_LONG) {
+        return TINY_ARG_LONG_LONG;
+      }
+#endif
+      return TINY_ARG_INT;
+    case 'c':
+      return TINY_ARG_INT;
+    case 'p':
+    case 'h':
+    case 'H':
+      return TINY_ARG_POINTER;
+#ifdef TINY_PRINTF_TIMESTAMP
+    case 'T':
+#ifdef TINY_PRINTF_LONG_LONG
+      if(op.options & TINY_FORMAT_LONG_LONG) {
+        return TINY_ARG_LONG_LONG;
+      }
+#endif
+      return TINY_ARG_POINTER;
+#endif
+#ifdef TINY_PRINTF_FLOAT
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'r':
+      return TINY_ARG_DOUBLE;
+#endif
+    default:
+      type = CustomArgType(op.specifier, std::make_index_sequence<256>());
+#ifdef TINY_PRINTF_LONG_LONG
+      if(type == TINY_ARG_INT && (op.options & TINY_FORMAT_LONG_LONG)) {
+        return TINY_ARG_LONG_LONG;
+      }
+#endif
+      return type;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Get the number of arguments of an operation, same as TinyFormatGetArgCount()
+ **********************************************************************************************************************/
+template<int = 0>
+constexpr int ArgCount(
+  /// [in] Operation
+  const Op &op)
+{
+  if(op.specifier == '\0') {
+    return 0;
+  }
+
+  return (op.width == TINY_FORMAT_STAR) + (op.precision == TINY_FORMAT_STAR) + (ArgType(op) != TINY_ARG_NONE);
+}
+
+/**********************************************************************************************************************/
+/** Parse one format specifier, same as TinyParseSpecifier()
+ ***********************************************************************************************************************
+ *
+ * @returns position of the character following the specifier
+ *
+ **********************************************************************************************************************/
+constexpr std::size_t ParseSpecifier(
+  /// [in] Format string
+  const char *format,
+  /// [in] Position after the '%' character
+  std::size_t i,
+  /// [out] Parsed conversion
+  Op &op)
+{
+  int width = 0, options = 0, precision = 6;
+
+  for(;; ++i) {
+    if(format[i] == '-') {
+      options |= TINY_FORMAT_PAD_RIGHT;
+    }
+    else if(format[i] == '0') {
+      options |= TINY_FORMAT_PAD_ZERO;
+    }
+    else if(format[i] == '+') {
+      options |= TINY_FORMAT_PLUS;
+    }
+    else if(format[i] == ' ') {
+      options |= TINY_FORMAT_SPACE;
+    }
+    else if(format[i] == '#') {
+      options |= TINY_FORMAT_ALT;
+    }
+    else {
+      break;
+    }
+  }
+  if(format[i] == '*') {
+    ++i;
+    width = TINY_FORMAT_STAR;
+  }
+  else {
+    for(; format[i] >= '0' && format[i] <= '9'; ++i) {
+      width = width * 10 + (format[i] - '0');
+    }
+  }
+  if(format[i] == '.') {
+    ++i;
+    options |= TINY_FORMAT_PRECISION;
+    precision = 0;
+    if(format[i] == '*') {
+      ++i;
+      precision = TINY_FORMAT_STAR;
+    }
+    else {
+      for(; format[i] >= '0' && format[i] <= '9'; ++i) {
+        precision = precision * 10 + (format[i] - '0');
+      }
+    }
+  }
+  if(format[i] == 'l') {
+    ++i;
+    if(format[i] == 'l') {
+      ++i;
+      options |= TINY_FORMAT_LONG_LONG;
+    }
+  }
+  for(; format[i] == 'h'; ++i);
+
+  op.specifier = format[i];
+  op.options = static_cast<unsigned char>(options);
+  op.width = width;
+  op.precision = precision;
+  op.modifier = '\0';
+
+  if(format[i] == 'p' && (format[i + 1] == 'h' || format[i + 1] == 'H')) {
+    op.specifier = format[++i];
+    switch(format[i + 1]) {
+      case 'C':
+        op.modifier = ':';
+        ++i;
+        break;
+      case 'D':
+        op.modifier = '-';
+        ++i;
+        break;
+      case 'S':
+        op.modifier = ' ';
+        ++i;
+        break;
+      case 'N':
+        ++i;
+        break;
+    }
+  }
+
+  return (format[i] != '\0') ? i + 1 : i;
+}
+
+/**********************************************************************************************************************/
+/** Compile a format string, same as TinyFormatCompile()
+ ***********************************************************************************************************************
+ *
+ * @returns number of operations
+ *
+ **********************************************************************************************************************/
+constexpr int Compile(
+  /// [in] Format string
+  const char *format,
+  /// [out] Operations (nullptr to count them only)
+  Op *ops)
+{
+  std::size_t i = 0;
+  int count = 0;
+
+  while(format[i] != '\0') {
+    Op op{};
+    std::size_t start = i;
+
+    for(; format[i] != '\0' && format[i] != '%'; ++i);
+    op.literal = start;
+    op.literalLength = static_cast<int>(i - start);
+    op.specifier = '\0';
+
+    if(format[i] == '%') {
+      if(format[i + 1] == '%') {
+        op.literalLength++;
+        i += 2;
+      }
+      else {
+        i = ParseSpecifier(format, i + 1, op);
+      }
+    }
+    if(ops != nullptr) {
+      ops[count] = op;
+    }
+    count++;
+  }
+
+  return count;
+}
+
+/**********************************************************************************************************************/
+/** Compile time parsed format
+ **********************************************************************************************************************/
+template<FormatString F>
+struct Parsed {
+  /// Number of operations
+  static constexpr int count = Compile(F.data, nullptr);
+
+  /// Operations
+  static constexpr std::array<Op, count> ops = [] {
+    std::array<Op, count> ops{};
+    Compile(F.data, ops.data());
+    return ops;
+  }();
+
+  /// Number of arguments
+  static constexpr std::size_t args = [] {
+    std::size_t args = 0;
+    for(const Op &op : ops) {
+      args += ArgCount(op);
+    }
+    return args;
+  }();
+
+  /// Argument types in the order they are consumed
+  static constexpr std::array<TinyFormatArgType, args> types = [] {
+    std::array<TinyFormatArgType, args> types{};
+    std::size_t i = 0;
+    for(const Op &op : ops) {
+      if(ArgCount(op) != 0 && op.width == TINY_FORMAT_STAR) {
+        types[i++] = TINY_ARG_INT;
+      }
+      if(ArgCount(op) != 0 && op.precision == TINY_FORMAT_STAR) {
+        types[i++] = TINY_ARG_INT;
+      }
+      if(ArgType(op) != TINY_ARG_NONE) {
+        types[i++] = ArgType(op);
+      }
+    }
+    return types;
+  }();
+
+  /// Index of the first argument consumed by an operation
+  static constexpr std::size_t ArgIndex(
+    /// [in] Index of the operation
+    int op)
+  {
+    std::size_t i = 0;
+    for(int j = 0; j < op; j++) {
+      i += ArgCount(ops[j]);
+    }
+    return i;
+  }
+};
+
+/// Strings taken as NUL terminated character pointers (string literals, character arrays and pointers)
+template<typename T>
+inline constexpr bool isCString = std::is_convertible_v<const T &, const char *>;
+
+/// Pointers accepted by %p and hex dumps (object pointers and arrays)
+template<typename T>
+inline constexpr bool isPointer = std::is_null_pointer_v<T> || std::is_array_v<T> ||
+                                  (std::is_pointer_v<T> && !std::is_function_v<std::remove_pointer_t<T>>);
+
+/**********************************************************************************************************************/
+/** Check whether an argument type can be passed to a conversion
+ **********************************************************************************************************************/
+template<typename T>
+constexpr bool Accepts(
+  /// [in] Argument type of the conversion
+  TinyFormatArgType type)
+{
+  using U = std::remove_cvref_t<T>;
+  constexpr bool integer = std::is_integral_v<U> || std::is_enum_v<U>;
+
+  switch(type) {
+    case TINY_ARG_INT:
+      return integer && sizeof(U) <= sizeof(int);
+    case TINY_ARG_LONG_LONG:
+      return integer && sizeof(U) <= sizeof(long long int);
+    case TINY_ARG_DOUBLE:
+      return std::is_floating_point_v<U> && sizeof(U) <= sizeof(double);
+    case TINY_ARG_STRING:
+      return isCString<U> || std::is_convertible_v<const U &, std::string_view>;
+    case TINY_ARG_POINTER:
+      return isPointer<U>;
+    default:
+      return false;
+  }
+}
+
+/**********************************************************************************************************************/
+/** Check all arguments of a format
+ **********************************************************************************************************************/
+template<FormatString F, typename... Args, std::size_t... I>
+constexpr bool AcceptsAll(std::index_sequence<I...>)
+{
+  return (Accepts<Args>(Parsed<F>::types[I]) && ...);
+}
+
+/**********************************************************************************************************************/
+/** Print the conversion of one operation
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+template<FormatString F, int I, typename T>
+inline int Convert(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx,
+  /// [in] Argument of the conversion
+  const T &arg,
+  /// [in] Desired width
+  int width,
+  /// [in] Formatting options
+  int options,
+  /// [in] Precision
+  int precision)
+{
+  using U = std::remove_cvref_t<T>;
+  constexpr Op op = Parsed<F>::ops[I];
+  constexpr TinyFormatArgType type = ArgType(op);
+
+  if constexpr(op.specifier == 's') {
+    if constexpr(isCString<U>) {
+      const char *string = arg;
+      std::size_t length;
+      if(string == nullptr) {
+        string = "(null)";
+      }
+      if(options & TINY_FORMAT_PRECISION) {
+        // The string need not be terminated within the precision
+        const void *end = std::memchr(string, '\0', precision);
+        length = (end != nullptr) ? static_cast<const char *>(end) - string : precision;
+      }
+      else {
+        length = std::strlen(string);
+      }
+      return TinyFormatPadded(printspan, ctx, string, static_cast<int>(length), width, options);
+    }
+    else {
+      std::string_view string(arg);
+      if((options & TINY_FORMAT_PRECISION) && string.size() > static_cast<std::size_t>(precision)) {
+        string = string.substr(0, precision);
+      }
+      return TinyFormatPadded(printspan, ctx, string.data(), static_cast<int>(string.size()), width, options);
+    }
+  }
+  else if constexpr(op.specifier == 'c') {
+    char c = static_cast<char>(arg);
+    return TinyFormatPadded(printspan, ctx, &c, 1, width, options);
+  }
+  else if constexpr(op.specifier == 'h' || op.specifier == 'H') {
+    const TinyFormatOp conversion = { nullptr, 0, op.specifier, op.options, 0, precision, op.modifier };
+    return TinyFormatHexDump(printspan, ctx, static_cast<const void *>(arg), width, &conversion);
+  }
+  else if constexpr(op.specifier == 'p') {
+    std::size_t address = reinterpret_cast<std::size_t>(static_cast<const void *>(arg));
+#ifdef TINY_PRINTF_LONG_LONG
+    if constexpr(sizeof(void *) > sizeof(int)) {
+      return TinyFormatIntegerLongLong(printspan, ctx, static_cast<long long int>(address), 16, 0,
+                                       sizeof(void *) * 2, TINY_FORMAT_PAD_ZERO, 'A');
+    }
+#endif
+    return TinyFormatInteger(printspan, ctx, static_cast<int>(address), 16, 0, sizeof(void *) * 2,
+                             TINY_FORMAT_PAD_ZERO, 'A');
+  }
+  else if constexpr(op.specifier == 'T' || op.specifier == 'k' ||
+                    CustomConversion<op.specifier>::type != TINY_ARG_NONE) {
+    // Timestamps (cached per thread in tiny_printf.c), fixed point numbers and registered conversions are dispatched at
+    // run time
+    const TinyFormatOp conversion = {
+      nullptr, 0, op.specifier, static_cast<unsigned char>(options), width, precision, op.modifier
+    };
+    TinyFormatArg value;
+    if constexpr(type == TINY_ARG_INT) {
+      value.i = static_cast<int>(arg);
+    }
+    else if constexpr(type == TINY_ARG_LONG_LONG) {
+      value.ll = static_cast<long long int>(arg);
+    }
+    else if constexpr(type == TINY_ARG_DOUBLE) {
+      value.f = static_cast<double>(arg);
+    }
+    else if constexpr(type == TINY_ARG_STRING) {
+      static_assert(isCString<U>, "registered string conversions take NUL terminated strings");
+      value.s = arg;
+    }
+    else {
+      value.p = static_cast<const void *>(arg);
+    }
+    return TinyFormatConvert(printspan, ctx, &conversion, &value);
+  }
+#ifdef TINY_PRINTF_FLOAT
+  else if constexpr(type == TINY_ARG_DOUBLE) {
+    const TinyFormatOp conversion = {
+      nullptr, 0, op.specifier, static_cast<unsigned char>(options), width, precision, op.modifier
+    };
+    return TinyFormatFloat(printspan, ctx, static_cast<double>(arg), &conversion);
+  }
+#endif
+  else {
+    // d, u, x and X
+    constexpr int base = (op.specifier == 'd' || op.specifier == 'u') ? 10 : 16;
+    constexpr int letbase = (op.specifier == 'X') ? 'A' : 'a';
+#ifdef TINY_PRINTF_LONG_LONG
+    if constexpr(type == TINY_ARG_LONG_LONG) {
+      return TinyFormatIntegerLongLong(printspan, ctx, static_cast<long long int>(arg), base, op.specifier == 'd',
+                                       width, options, letbase);
+    }
+#endif
+    return TinyFormatInteger(printspan, ctx, static_cast<int>(arg), base, op.specifier == 'd', width, options, letbase);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Print one operation
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+template<FormatString F, int I, typename Tuple>
+inline int Emit(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx,
+  /// [in] Format arguments
+  const Tuple &args)
+{
+  constexpr Op op = Parsed<F>::ops[I];
+  int pc = 0;
+
+  if constexpr(op.literalLength != 0) {
+    printspan(ctx, F.data + op.literal, op.literalLength);
+    pc += op.literalLength;
+  }
+  if constexpr(ArgType(op) != TINY_ARG_NONE) {
+    // The '*' width and precision come in front of the argument
+    constexpr std::size_t arg = Parsed<F>::ArgIndex(I) + ArgCount(op) - 1;
+    int width = op.width, options = op.options, precision = op.precision;
+    if constexpr(op.width == TINY_FORMAT_STAR) {
+      // Negative widths mean left justification, as in printf(), negative hex dump lengths dump nothing
+      width = static_cast<int>(std::get<Parsed<F>::ArgIndex(I)>(args));
+      if(width < 0 && (op.specifier == 'h' || op.specifier == 'H')) {
+        width = 0;
+      }
+      else if(width < 0) {
+        options |= TINY_FORMAT_PAD_RIGHT;
+        width = -width;
+      }
+    }
+    if constexpr(op.precision == TINY_FORMAT_STAR) {
+      // Negative precisions are taken as if the precision was omitted
+      precision = static_cast<int>(std::get<arg - 1>(args));
+      if(precision < 0) {
+        options &= ~TINY_FORMAT_PRECISION;
+        precision = 6;
+      }
+    }
+    pc += Convert<F, I>(printspan, ctx, std::get<arg>(args), width, options, precision);
+  }
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Print all operations
+ **********************************************************************************************************************/
+template<FormatString F, typename Tuple, int... I>
+inline int Run(printspan_t printspan, void *ctx, const Tuple &args, std::integer_sequence<int, I...>)
+{
+  int pc = 0;
+
+  ((pc += Emit<F, I>(printspan, ctx, args)), ...);
+
+  return pc;
+}
+
+/// Context of the SNprintf() printspan function
+struct SNPrintSpanContext {
+  /// Current string write pointer
+  char *string;
+  /// Number of bytes left in the string buffer
+  int length;
+};
+
+/**********************************************************************************************************************/
+/** Put a span of bytes into sized buffer
+ **********************************************************************************************************************/
+inline void SNPrintSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  std::size_t length)
+{
+  SNPrintSpanContext *ctx = static_cast<SNPrintSpanContext *>(context);
+
+  if(ctx->length <= 0) {
+    return;
+  }
+  if(length > static_cast<std::size_t>(ctx->length)) {
+    length = ctx->length;
+  }
+  std::memcpy(ctx->string, string, length);
+  ctx->string += length;
+  ctx->length -= static_cast<int>(length);
+}
+
+/// Context of the Printf() printspan function
+struct PrintCharSpanContext {
+  /// printchar function pointer
+  printchar_t printchar;
+  /// context for printchar function
+  void *ctx;
+};
+
+/**********************************************************************************************************************/
+/** Hand a span of bytes to a printchar function one by one
+ **********************************************************************************************************************/
+inline void PrintCharSpan(
+  /// [in] Pointer to the context
+  void *context,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  std::size_t length)
+{
+  PrintCharSpanContext *ctx = static_cast<PrintCharSpanContext *>(context);
+
+  while(length--) {
+    ctx->printchar(ctx->ctx, *string++);
+  }
+}
+
+} // namespace detail
+
+/**********************************************************************************************************************/
+/** Formatted output to a printspan function, see TinyPrintfSpan()
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+template<FormatString F, typename... Args>
+inline int PrintfSpan(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx,
+  /// [in] Format arguments
+  const Args &...args)
+{
+  using P = detail::Parsed<F>;
+
+  static_assert(sizeof...(Args) == P::args, "Number of arguments does not match the format string");
+  if constexpr(sizeof...(Args) == P::args) {
+    static_assert(detail::AcceptsAll<F, Args...>(std::index_sequence_for<Args...>()),
+                  "Argument type does not match its conversion");
+  }
+
+  return detail::Run<F>(printspan, ctx, std::forward_as_tuple(args...), std::make_integer_sequence<int, P::count>());
+}
+
+/**********************************************************************************************************************/
+/** Formatted output to a printchar function, see TinyPrintf()
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+template<FormatString F, typename... Args>
+inline int Printf(
+  /// [in] printchar function pointer
+  printchar_t printchar,
+  /// [in] context for printchar function
+  void *ctx,
+  /// [in] Format arguments
+  const Args &...args)
+{
+  detail::PrintCharSpanContext context = { printchar, ctx };
+
+  return PrintfSpan<F>(detail::PrintCharSpan, &context, args...);
+}
+
+/**********************************************************************************************************************/
+/** Write formatted output to sized buffer, see TinySNprintf()
+ ***********************************************************************************************************************
+ *
+ * @returns
+ * The number of characters that would have been written if length had been sufficiently large, not counting the
+ * terminating null character.
+ *
+ **********************************************************************************************************************/
+template<FormatString F, typename... Args>
+inline int SNprintf(
+  /// [in] String to print into
+  char *string,
+  /// [in] Maximum number of bytes to be used in the buffer, including the terminating null character
+  int length,
+  /// [in] Format arguments
+  const Args &...args)
+{
+  detail::SNPrintSpanContext context = { string, length - 1 };
+  int ret = PrintfSpan<F>(detail::SNPrintSpan, &context, args...);
+
+  context.length++;
+  detail::SNPrintSpan(&context, "", 1);
+
+  return ret;
+}
+
+} // namespace tiny
+
+#endif //TINY_PRINTF_HPP_
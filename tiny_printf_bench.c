@@ -0,0 +1,512 @@
+/**********************************************************************************************************************/
+/** Tiny printf benchmark
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Hosted benchmark comparing TinySNprintf(), TinyPrintf() into a sink doing nothing and the C library snprintf(),
+ * build it with:
+ * cc -O2 -DTINY_PRINTF_LONG_LONG -DTINY_PRINTF_FLOAT=double tiny_printf.c tiny_printf_bench.c -o tiny_printf_bench
+ *
+ * With -DBENCH_PARALLEL tiny_parallel.c -lpthread the scaling of TinyParallelBatch() from one thread to one thread
+ * per processor is measured as well.
+ *
+ * A table is printed to stdout. If a file name is given as argument, the results are also written there as CSV with
+ * the columns: case, format, engine, ns_per_call, ticks_per_call, bytes_per_call, mbytes_per_s
+ *
+ * @file tiny_printf_bench.c
+ *
+ **********************************************************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+#include "tiny_printf.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <stddef.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifdef BENCH_PARALLEL
+#include "tiny_parallel.h"
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+/// Number of pseudo random argument sets
+#define BENCH_VALUES 4096
+/// Minimum run time of one measurement in nanoseconds
+#define BENCH_MIN_NS 100000000ull
+
+/// Formatting function under test
+typedef int (*BenchEngine)(char *buf, int length, const char *format, ...);
+
+/// Argument kinds of the benchmark cases
+typedef enum {
+  BENCH_ARG_STRING,
+  BENCH_ARG_INT,
+  BENCH_ARG_LONG_LONG,
+  BENCH_ARG_DOUBLE,
+  BENCH_ARG_CHAR,
+  BENCH_ARG_LOG_LINE,
+  BENCH_ARG_LOG_LINE_FLOAT
+} BenchArg;
+
+/// Benchmark case
+typedef struct {
+  /// Name of the case
+  const char *name;
+  /// Format string
+  const char *format;
+  /// Kind of the arguments
+  BenchArg arg;
+} BenchCase;
+
+/// Benchmark cases
+static const BenchCase benchCases[] = {
+  { "string",          "%s",                                           BENCH_ARG_STRING },
+  { "string_padded",   "[%-16s]",                                      BENCH_ARG_STRING },
+  { "int",             "%d",                                           BENCH_ARG_INT },
+  { "int_padded",      "%08d",                                         BENCH_ARG_INT },
+  { "unsigned",        "%u",                                           BENCH_ARG_INT },
+  { "hex",             "%x",                                           BENCH_ARG_INT },
+  { "hex_padded",      "0x%08X",                                       BENCH_ARG_INT },
+  { "char",            "%c",                                           BENCH_ARG_CHAR },
+  { "char_padded",     "%4c",                                          BENCH_ARG_CHAR },
+#ifdef TINY_PRINTF_LONG_LONG
+  { "long_long",       "%lld",                                         BENCH_ARG_LONG_LONG },
+  { "long_long_hex",   "%016llx",                                      BENCH_ARG_LONG_LONG },
+#endif
+#ifdef TINY_PRINTF_FLOAT
+  { "float",           "%f",                                           BENCH_ARG_DOUBLE },
+  { "float_precision", "%10.3f",                                       BENCH_ARG_DOUBLE },
+  { "float_exponent",  "%e",                                           BENCH_ARG_DOUBLE },
+  { "float_general",   "%g",                                           BENCH_ARG_DOUBLE },
+#endif
+  { "log_line",        "%s:%d: [%5s] %-8s id=%08x count=%u\n",         BENCH_ARG_LOG_LINE },
+#ifdef TINY_PRINTF_FLOAT
+  { "log_line_float",  "%s %-6s sensor=%u value=%.3f limit=%.1f\n",    BENCH_ARG_LOG_LINE_FLOAT },
+#endif
+};
+
+/// Strings used as arguments
+static const char *const benchStrings[] = {
+  "main.c", "INFO", "WARN", "ERROR", "tiny_printf.c", "a", "connection established", "sensor", "", "uart0"
+};
+
+/// Pseudo random integer arguments with a spread of digit counts
+static unsigned long long benchValues[BENCH_VALUES];
+/// Pseudo random floating point arguments
+static double benchDoubles[BENCH_VALUES];
+
+/**********************************************************************************************************************/
+/** Read the monotonic clock
+ ***********************************************************************************************************************
+ *
+ * @returns nanoseconds
+ *
+ **********************************************************************************************************************/
+static unsigned long long BenchNanoseconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**********************************************************************************************************************/
+/** Read a timestamp
+ ***********************************************************************************************************************
+ *
+ * @returns CPU cycles where available, nanoseconds otherwise
+ *
+ **********************************************************************************************************************/
+static unsigned long long BenchTicks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return BenchNanoseconds();
+#endif
+}
+
+/**********************************************************************************************************************/
+/** Generate pseudo random arguments
+ **********************************************************************************************************************/
+static void BenchValues(void)
+{
+  unsigned long long x = 0x9E3779B97F4A7C15ull;
+  int i;
+
+  for(i = 0; i < BENCH_VALUES; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    // Shift by a random amount so small and large values are equally represented
+    benchValues[i] = x >> (x & 63);
+    // Telemetry like values with a few decimals
+    benchDoubles[i] = ((double)(x % 2000000) - 1000000.0) / (double)(1 << (x >> 59));
+  }
+}
+
+/**********************************************************************************************************************/
+/** printchar function doing nothing
+ **********************************************************************************************************************/
+static void BenchNullPrintChar(
+  /// [in] Context (unused)
+  void *ctx,
+  /// [in] Character (unused)
+  char c)
+{
+  (void)ctx;
+  (void)c;
+}
+
+/**********************************************************************************************************************/
+/** Engine: TinyPrintf() into a printchar function doing nothing
+ **********************************************************************************************************************/
+static int BenchTinyNullSink(char *buf, int length, const char *format, ...)
+{
+  va_list args;
+  int ret;
+
+  (void)buf;
+  (void)length;
+  va_start(args, format);
+  ret = TinyPrintf(BenchNullPrintChar, NULL, format, args);
+  va_end(args);
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Engine: C library snprintf()
+ **********************************************************************************************************************/
+static int BenchLibc(char *buf, int length, const char *format, ...)
+{
+  va_list args;
+  int ret;
+
+  va_start(args, format);
+  ret = vsnprintf(buf, length, format, args);
+  va_end(args);
+
+  return ret;
+}
+
+/**********************************************************************************************************************/
+/** Format one argument set of a case
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes formatted
+ *
+ **********************************************************************************************************************/
+static int BenchCall(
+  /// [in] Engine
+  BenchEngine engine,
+  /// [in] Case
+  const BenchCase *bench,
+  /// [in] Index of the argument set
+  int i,
+  /// [out] Output buffer
+  char *buf,
+  /// [in] Size of the output buffer
+  int length)
+{
+  const char *string = benchStrings[i % (sizeof(benchStrings) / sizeof(benchStrings[0]))];
+  unsigned long long value = benchValues[i];
+
+  switch(bench->arg) {
+    case BENCH_ARG_STRING:
+      return engine(buf, length, bench->format, string);
+    case BENCH_ARG_INT:
+      return engine(buf, length, bench->format, (int)value);
+    case BENCH_ARG_LONG_LONG:
+      return engine(buf, length, bench->format, (long long)value);
+    case BENCH_ARG_DOUBLE:
+      return engine(buf, length, bench->format, benchDoubles[i]);
+    case BENCH_ARG_CHAR:
+      return engine(buf, length, bench->format, 'A' + (int)(value % 26));
+    case BENCH_ARG_LOG_LINE:
+      return engine(buf, length, bench->format, "tiny_printf.c", (int)(value % 2000), "INFO", string, (int)value,
+                    (unsigned)(value >> 40));
+    case BENCH_ARG_LOG_LINE_FLOAT:
+      return engine(buf, length, bench->format, "12:00:01", "WARN", (unsigned)(value % 64), benchDoubles[i],
+                    benchDoubles[(i + 1) % BENCH_VALUES]);
+  }
+
+  return 0;
+}
+
+/**********************************************************************************************************************/
+/** Measure one case with one engine
+ **********************************************************************************************************************/
+static void BenchRun(
+  /// [in] Case
+  const BenchCase *bench,
+  /// [in] Engine
+  BenchEngine engine,
+  /// [in] Name of the engine
+  const char *engineName,
+  /// [in] CSV output file (NULL for none)
+  FILE *csv)
+{
+  char buf[256];
+  unsigned long long start, ticks, ns, calls = 0, bytes = 0;
+  int i;
+
+  // Warm up
+  for(i = 0; i < BENCH_VALUES; i++) {
+    BenchCall(engine, bench, i, buf, sizeof(buf));
+  }
+
+  start = BenchNanoseconds();
+  ticks = BenchTicks();
+  do {
+    for(i = 0; i < BENCH_VALUES; i++) {
+      bytes += BenchCall(engine, bench, i, buf, sizeof(buf));
+    }
+    calls += BENCH_VALUES;
+    ns = BenchNanoseconds() - start;
+  } while(ns < BENCH_MIN_NS);
+  ticks = BenchTicks() - ticks;
+
+  printf("%-16s %-15s %9.1f ns %9.1f ticks %7.1f B %9.1f MB/s\n", bench->name, engineName, (double)ns / calls,
+         (double)ticks / calls, (double)bytes / calls, (double)bytes * 1000.0 / ns);
+  if(csv != NULL) {
+    fprintf(csv, "%s,\"", bench->name);
+    for(i = 0; bench->format[i]; i++) {
+      // Escape the format string for CSV
+      if(bench->format[i] == '\n') {
+        fputs("\\n", csv);
+      }
+      else {
+        if(bench->format[i] == '"') {
+          fputc('"', csv);
+        }
+        fputc(bench->format[i], csv);
+      }
+    }
+    fprintf(csv, "\",%s,%.2f,%.2f,%.2f,%.2f\n", engineName, (double)ns / calls, (double)ticks / calls,
+            (double)bytes / calls, (double)bytes * 1000.0 / ns);
+  }
+}
+
+/// Record of the batch benchmark
+typedef struct {
+  /// Identifier
+  int id;
+  /// Counter
+  unsigned int count;
+  /// Flags
+  unsigned int flags;
+  /// Source
+  const char *source;
+} BenchRecord;
+
+/// Format of the batch benchmark
+static const char benchBatchFormat[] = "%d,%u,%x,%s\n";
+
+/// Fields of the batch benchmark
+static const TinyFormatField benchBatchFields[] = {
+  { offsetof(BenchRecord, id),     TINY_FIELD_INT },
+  { offsetof(BenchRecord, count),  TINY_FIELD_UINT },
+  { offsetof(BenchRecord, flags),  TINY_FIELD_UINT },
+  { offsetof(BenchRecord, source), TINY_FIELD_STRING },
+};
+
+/**********************************************************************************************************************/
+/** Measure formatting a table row by row with TinySNprintf() and with TinyFormatBatch()
+ **********************************************************************************************************************/
+static void BenchBatch(
+  /// [in] CSV output file (NULL for none)
+  FILE *csv)
+{
+  static BenchRecord records[BENCH_VALUES];
+  static char buf[BENCH_VALUES * 64];
+  TinyFormatOp ops[8];
+  TinyFormat compiled;
+  unsigned long long start, ticks, ns, calls, bytes;
+  int engine, i;
+
+  for(i = 0; i < BENCH_VALUES; i++) {
+    records[i].id = (int)benchValues[i];
+    records[i].count = (unsigned int)(benchValues[i] >> 20);
+    records[i].flags = (unsigned int)(benchValues[i] >> 40);
+    records[i].source = benchStrings[i % (sizeof(benchStrings) / sizeof(benchStrings[0]))];
+  }
+  TinyFormatCompile(&compiled, ops, 8, benchBatchFormat);
+
+  for(engine = 0; engine < 2; engine++) {
+    const char *engineName = engine ? "TinyFormatBatch" : "TinySNprintf";
+    calls = 0;
+    bytes = 0;
+    start = BenchNanoseconds();
+    ticks = BenchTicks();
+    do {
+      size_t length = 0;
+      if(engine) {
+        size_t offsets[BENCH_VALUES + 1];
+        TinyFormatBatch(&compiled, benchBatchFields, records, sizeof(BenchRecord), BENCH_VALUES, buf, sizeof(buf),
+                        offsets);
+        length = offsets[BENCH_VALUES];
+      }
+      else {
+        for(i = 0; i < BENCH_VALUES; i++) {
+          length += TinySNprintf(buf + length, sizeof(buf) - length, benchBatchFormat, records[i].id, records[i].count,
+                                 records[i].flags, records[i].source);
+        }
+      }
+      bytes += length;
+      calls += BENCH_VALUES;
+      ns = BenchNanoseconds() - start;
+    } while(ns < BENCH_MIN_NS);
+    ticks = BenchTicks() - ticks;
+
+    printf("%-16s %-15s %9.1f ns %9.1f ticks %7.1f B %9.1f MB/s\n", "table_row", engineName, (double)ns / calls,
+           (double)ticks / calls, (double)bytes / calls, (double)bytes * 1000.0 / ns);
+    if(csv != NULL) {
+      fprintf(csv, "table_row,\"%%d,%%u,%%x,%%s\\n\",%s,%.2f,%.2f,%.2f,%.2f\n", engineName, (double)ns / calls,
+              (double)ticks / calls, (double)bytes / calls, (double)bytes * 1000.0 / ns);
+    }
+  }
+}
+
+#ifdef BENCH_PARALLEL
+/// Number of records of the parallel benchmark
+#define BENCH_PARALLEL_RECORDS (BENCH_VALUES * 256)
+
+/**********************************************************************************************************************/
+/** Allocator of the parallel benchmark
+ **********************************************************************************************************************/
+static void *BenchReallocate(
+  /// [in] Allocator context (unused)
+  void *ctx,
+  /// [in] Memory to resize, NULL to allocate
+  void *memory,
+  /// [in] New size, 0 to release
+  size_t size)
+{
+  (void)ctx;
+  if(size == 0) {
+    free(memory);
+    return NULL;
+  }
+  return realloc(memory, size);
+}
+
+/**********************************************************************************************************************/
+/** Measure TinyParallelBatch() from one thread to one thread per processor
+ **********************************************************************************************************************/
+static void BenchParallel(
+  /// [in] CSV output file (NULL for none)
+  FILE *csv)
+{
+  BenchRecord *records = malloc(BENCH_PARALLEL_RECORDS * sizeof(BenchRecord));
+  char *buf = malloc(BENCH_PARALLEL_RECORDS * 64);
+  int processors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  TinyFormatOp ops[8];
+  TinyFormat compiled;
+  TinyParallelJob job;
+  double single = 0;
+  int threads, i;
+
+  if(records == NULL || buf == NULL) {
+    free(records);
+    free(buf);
+    return;
+  }
+  for(i = 0; i < BENCH_PARALLEL_RECORDS; i++) {
+    records[i].id = (int)benchValues[i % BENCH_VALUES];
+    records[i].count = (unsigned int)(benchValues[(i * 7) % BENCH_VALUES] >> 20);
+    records[i].flags = (unsigned int)(benchValues[(i * 13) % BENCH_VALUES] >> 40);
+    records[i].source = benchStrings[i % (sizeof(benchStrings) / sizeof(benchStrings[0]))];
+  }
+  TinyFormatCompile(&compiled, ops, 8, benchBatchFormat);
+  job.compiled = &compiled;
+  job.fields = benchBatchFields;
+  job.records = records;
+  job.stride = sizeof(BenchRecord);
+  job.count = BENCH_PARALLEL_RECORDS;
+  job.blockRecords = 0;
+  job.reallocate = BenchReallocate;
+  job.allocCtx = NULL;
+
+  // Powers of two up to the number of processors and the number of processors itself
+  for(threads = 1; threads <= processors;
+      threads = (threads < processors && threads * 2 > processors) ? processors : threads * 2) {
+    unsigned long long start, ns, calls = 0, bytes = 0;
+    char engineName[32];
+    job.threads = threads;
+    start = BenchNanoseconds();
+    do {
+      bytes += TinyParallelBatchBuffer(&job, buf, BENCH_PARALLEL_RECORDS * 64);
+      calls += BENCH_PARALLEL_RECORDS;
+      ns = BenchNanoseconds() - start;
+    } while(ns < BENCH_MIN_NS);
+    if(threads == 1) {
+      single = (double)ns / calls;
+    }
+
+    snprintf(engineName, sizeof(engineName), "parallel_%d", threads);
+    printf("%-16s %-15s %9.1f ns %9.2f x    %7.1f B %9.1f MB/s\n", "table_row", engineName, (double)ns / calls,
+           single * calls / ns, (double)bytes / calls, (double)bytes * 1000.0 / ns);
+    if(csv != NULL) {
+      fprintf(csv, "table_row,\"%%d,%%u,%%x,%%s\\n\",%s,%.2f,,%.2f,%.2f\n", engineName, (double)ns / calls,
+              (double)bytes / calls, (double)bytes * 1000.0 / ns);
+    }
+  }
+
+  free(records);
+  free(buf);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+  FILE *csv = NULL;
+  unsigned int i;
+
+  if(argc > 1) {
+    csv = fopen(argv[1], "w");
+    if(csv == NULL) {
+      perror(argv[1]);
+      return 1;
+    }
+    fputs("case,format,engine,ns_per_call,ticks_per_call,bytes_per_call,mbytes_per_s\n", csv);
+  }
+
+  BenchValues();
+
+  for(i = 0; i < sizeof(benchCases) / sizeof(benchCases[0]); i++) {
+    BenchRun(&benchCases[i], TinySNprintf, "TinySNprintf", csv);
+    BenchRun(&benchCases[i], BenchTinyNullSink, "TinyPrintf", csv);
+    BenchRun(&benchCases[i], BenchLibc, "snprintf", csv);
+  }
+  BenchBatch(csv);
+#ifdef BENCH_PARALLEL
+  BenchParallel(csv);
+#endif
+
+  if(csv != NULL) {
+    fclose(csv);
+  }
+
+  return 0;
+}
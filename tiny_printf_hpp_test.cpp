@@ -0,0 +1,302 @@
+/**********************************************************************************************************************/
+/** Tiny printf C++ front end tests
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Hosted checks of tiny_printf.hpp against the C functions, build and run them with:
+ * cc -c -DTINY_PRINTF_LONG_LONG -DTINY_PRINTF_FLOAT=double tiny_printf.c
+ * c++ -std=c++20 -DTINY_PRINTF_LONG_LONG -DTINY_PRINTF_FLOAT=double tiny_printf.o tiny_printf_hpp_test.cpp \
+ *     -o tiny_printf_hpp_test
+ * ./tiny_printf_hpp_test
+ *
+ * @file tiny_printf_hpp_test.cpp
+ *
+ **********************************************************************************************************************/
+
+#include "tiny_printf.hpp"
+#include "tiny_test.h"
+#include <climits>
+#include <cstdarg>
+#include <string>
+#include <string_view>
+
+/// Argument type of the conversion registered by main()
+template<>
+struct tiny::CustomConversion<'I'> {
+  /// Takes an int
+  static constexpr TinyFormatArgType type = TINY_ARG_INT;
+};
+
+/// Compare the output of a format with the C functions
+#define TEST_SAME(format, ...) TestSame<format>(__LINE__ __VA_OPT__(,) __VA_ARGS__)
+
+/// Collected output
+struct TestRecord {
+  /// Characters, null terminated
+  char string[256];
+  /// Number of characters
+  std::size_t length;
+};
+
+/**********************************************************************************************************************/
+/** Append a span to a record
+ **********************************************************************************************************************/
+static void TestRecordSpan(
+  /// [in] Pointer to the record
+  void *ctx,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  std::size_t length)
+{
+  TestRecord *record = static_cast<TestRecord *>(ctx);
+
+  if(length > sizeof(record->string) - 1 - record->length) {
+    length = sizeof(record->string) - 1 - record->length;
+  }
+  std::memcpy(record->string + record->length, string, length);
+  record->length += length;
+  record->string[record->length] = '\0';
+}
+
+/**********************************************************************************************************************/
+/** Append a character to a record
+ **********************************************************************************************************************/
+static void TestRecordChar(
+  /// [in] Pointer to the record
+  void *ctx,
+  /// [in] Character to print
+  char c)
+{
+  TestRecordSpan(ctx, &c, 1);
+}
+
+/**********************************************************************************************************************/
+/** Print with TinyPrintfSpan() into a record
+ ***********************************************************************************************************************
+ *
+ * @returns number of bytes printed
+ *
+ **********************************************************************************************************************/
+static int TestPrintfSpan(
+  /// [out] Record, cleared first
+  TestRecord *record,
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  ...)
+{
+  std::va_list args;
+  int pc;
+
+  record->length = 0;
+  record->string[0] = '\0';
+  va_start(args, format);
+  pc = TinyPrintfSpan(TestRecordSpan, record, format, args);
+  va_end(args);
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Report output differing between the front ends
+ **********************************************************************************************************************/
+static void TestReport(
+  /// [in] Line of the check
+  int line,
+  /// [in] What was compared
+  const char *what,
+  /// [in] Output of tiny_printf.hpp
+  const char *cpp,
+  /// [in] Its return value
+  int cppLength,
+  /// [in] Output of the C function
+  const char *c,
+  /// [in] Its return value
+  int cLength)
+{
+  std::printf("%s:%d: %s: got \"%s\" (%d), expected \"%s\" (%d)\n", __FILE__, line, what, cpp, cppLength, c, cLength);
+  testFailures++;
+}
+
+/**********************************************************************************************************************/
+/** Format with tiny::SNprintf(), tiny::PrintfSpan() and tiny::Printf() and compare with TinySNprintf() and
+ *  TinyPrintfSpan(), SNprintf() also with every buffer size the output gets truncated to
+ **********************************************************************************************************************/
+template<tiny::FormatString F, typename... Args>
+static void TestSame(
+  /// [in] Line of the check
+  int line,
+  /// [in] Format arguments
+  const Args &...args)
+{
+  char cpp[256], c[256];
+  TestRecord cppRecord = {}, cRecord;
+  int cppLength, cLength, length;
+
+  cppLength = tiny::SNprintf<F>(cpp, sizeof(cpp), args...);
+  cLength = TinySNprintf(c, sizeof(c), F.data, args...);
+  if(cppLength != cLength || std::strcmp(cpp, c) != 0) {
+    TestReport(line, "SNprintf", cpp, cppLength, c, cLength);
+    return;
+  }
+
+  for(length = 0; length <= cLength; length++) {
+    std::memset(cpp, '#', sizeof(cpp));
+    std::memset(c, '#', sizeof(c));
+    cppLength = tiny::SNprintf<F>(cpp, length, args...);
+    cLength = TinySNprintf(c, length, F.data, args...);
+    if(cppLength != cLength || std::memcmp(cpp, c, sizeof(c)) != 0) {
+      cpp[length] = c[length] = '\0';
+      TestReport(line, "truncated SNprintf", cpp, cppLength, c, cLength);
+      return;
+    }
+  }
+
+  cLength = TestPrintfSpan(&cRecord, F.data, args...);
+  cppLength = tiny::PrintfSpan<F>(TestRecordSpan, &cppRecord, args...);
+  if(cppLength != cLength || std::strcmp(cppRecord.string, cRecord.string) != 0) {
+    TestReport(line, "PrintfSpan", cppRecord.string, cppLength, cRecord.string, cLength);
+  }
+
+  cppRecord.length = 0;
+  cppRecord.string[0] = '\0';
+  cppLength = tiny::Printf<F>(TestRecordChar, &cppRecord, args...);
+  if(cppLength != cLength || std::strcmp(cppRecord.string, cRecord.string) != 0) {
+    TestReport(line, "Printf", cppRecord.string, cppLength, cRecord.string, cLength);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Custom conversion printing an int in angle brackets
+ **********************************************************************************************************************/
+static int TestConvertAngle(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  int pc = 2;
+
+  printspan(ctx, "<", 1);
+  pc += TinyFormatInteger(printspan, ctx, arg->i, 10, 1, op->width, op->options, 'a');
+  printspan(ctx, ">", 1);
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Integers, characters and literal text
+ **********************************************************************************************************************/
+static void TestInteger(void)
+{
+  TEST_SAME("plain text");
+  TEST_SAME("100%% done, %%%d%%", 5);
+  TEST_SAME("%d|%5d|%-5d|%05d|%+d|% d|%-+6d|", 42, -42, 42, -42, 42, 42, 7);
+  TEST_SAME("%d %d %u %u", INT_MIN, INT_MAX, 0u, UINT_MAX);
+  TEST_SAME("%x %X %#x %08X %-8x|%hx %hhd", 0xbeefu, 0xbeefu, 255, 0xabc, 1, 0x1234, 'z');
+  TEST_SAME("%c%c%5c|%-3c|", 'a', 'b', 'c', 'd');
+  TEST_SAME("%*d|%-*d|%*d|%0*x", 6, 1, 6, 2, -6, 3, 4, 0xf);
+  TEST_SAME("%.2k %8.3k %-+9.1k|%.0k %#.4k", 12345, -5, 99, 7, INT_MIN);
+#ifdef TINY_PRINTF_LONG_LONG
+  TEST_SAME("%lld %llu %llx %20lld|%-20llX|", LLONG_MIN, ULLONG_MAX, 0x123456789abcdefull, -5ll, 0xfedcull);
+  TEST_SAME("%*lld|%.3llk", -12, 1234567890123ll, -9876543210ll);
+#endif
+}
+
+/**********************************************************************************************************************/
+/** Strings, pointers and hex dumps
+ **********************************************************************************************************************/
+static void TestPointer(void)
+{
+  static const unsigned char bytes[8] = { 0x00, 0x01, 0x7f, 0x80, 0xab, 0xcd, 0xef, 0xff };
+  static const char letters[3] = { 'a', 'b', 'c' };
+  const char *none = nullptr;
+  char buf[64];
+
+  TEST_SAME("%s|%10s|%-10s|%.2s|%8.3s|%-8.0s|", "one", "two", "three", "four", "five", "six");
+  TEST_SAME("[%s] [%.3s] [%.2s] [%5.9s]", none, letters, letters, "x");
+  TEST_SAME("%.*s|%.*s|%*.*s|", 2, "abcdef", -1, "abc", -7, 3, "ghijkl");
+  TEST_SAME("%p %p", static_cast<const void *>(bytes), none);
+  TEST_SAME("%*ph|%*phC|%4phD|%*.2phS|%*pH|", 5, bytes, 3, bytes, bytes, 8, bytes, -2, bytes);
+  TEST_SAME("%*.3pHS|%8phN|%0ph|", 8, bytes, bytes, bytes);
+
+  // std::string and std::string_view have no counterpart in C
+  TEST_CHECK(tiny::SNprintf<"[%-8s|%.3s|%3s]">(buf, sizeof(buf), std::string_view("view"), std::string("string"),
+                                                std::string_view("abcdef", 2)) == 18);
+  TEST_STRING(buf, "[view    |str| ab]");
+}
+
+#ifdef TINY_PRINTF_FLOAT
+/**********************************************************************************************************************/
+/** Floating point numbers
+ **********************************************************************************************************************/
+static void TestFloat(void)
+{
+  TEST_SAME("%f %.3f %e %g %10.2f %-+8.1f|%G", 3.14159, -2.5, 12345.678, 0.0001, 1e10, 7.25, 1e-20);
+  TEST_SAME("%.0f %#.0f %.10e %E %g %g", 0.5, 2.0, -1.0 / 3, 6.02214076e23, 1e300, -0.0);
+  TEST_SAME("%*.*f|%r|%.2r|%f", -10, 2, 1.005, 1234.5, 0.000125, 1.5f);
+}
+#endif
+
+#ifdef TINY_PRINTF_TIMESTAMP
+/**********************************************************************************************************************/
+/** Timestamps
+ **********************************************************************************************************************/
+static void TestTimestamp(void)
+{
+  struct timespec time = { 1715934600, 123456789 };
+
+  TEST_SAME("%T %.3T %#.9T|%30T|", &time, &time, &time, &time);
+#ifdef TINY_PRINTF_LONG_LONG
+  TEST_SAME("%llT %.6llT", 1715934600123456789ll, -1ll);
+#endif
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Registered conversions
+ **********************************************************************************************************************/
+static void TestCustom(void)
+{
+  TEST_SAME("%I|%5I|%-5I|%05I|", 7, -3, 12, 4);
+}
+
+int main(void)
+{
+  TEST_CHECK(TinyFormatRegister('I', TINY_ARG_INT, TestConvertAngle) == 0);
+
+  TestInteger();
+  TestPointer();
+#ifdef TINY_PRINTF_FLOAT
+  TestFloat();
+#endif
+#ifdef TINY_PRINTF_TIMESTAMP
+  TestTimestamp();
+#endif
+  TestCustom();
+
+  TEST_RESULT();
+}
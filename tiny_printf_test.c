@@ -0,0 +1,1373 @@
+/**********************************************************************************************************************/
+/** Tiny printf tests
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Hosted checks of behavior that is easy to break, build and run them with:
+ * cc -DTINY_PRINTF_LONG_LONG -DTINY_PRINTF_FLOAT=double tiny_printf.c tiny_printf_test.c -o tiny_printf_test
+ * ./tiny_printf_test
+ *
+ * Build it with -DTINY_PRINTF_STATS as well to check the statistics, with -DTINY_PRINTF_TIMESTAMP to check timestamps.
+ *
+ * Failed checks are printed to stdout, the exit code is the number of failed checks (see tiny_test.h).
+ *
+ * @file tiny_printf_test.c
+ *
+ **********************************************************************************************************************/
+
+#ifdef TINY_PRINTF_TIMESTAMP
+// struct timespec and gmtime_r() are POSIX, strict ISO C builds only declare them with a feature test macro
+#if !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
+#include "tiny_printf.h"
+#include "tiny_test.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#ifdef TINY_PRINTF_TIMESTAMP
+#include <time.h>
+#endif
+
+/// Check the output and the return value of TinySNprintf()
+#define TEST_PRINTF(expected, ...)                                                                                     \
+  do {                                                                                                                 \
+    char testOutput[512];                                                                                              \
+    TEST_CHECK(TinySNprintf(testOutput, sizeof(testOutput), __VA_ARGS__) == (int)strlen(expected));                    \
+    TEST_STRING(testOutput, expected);                                                                                 \
+  } while(0)
+
+/// Number of allocations left before the test allocator fails once, negative to never fail
+static int testAllocFailAfter = -1;
+/// Number of allocations and reallocations of the test allocator
+static int testAllocations;
+
+/**********************************************************************************************************************/
+/** Allocator failing once on request
+ **********************************************************************************************************************/
+static void *TestReallocate(
+  /// [in] Allocator context (unused)
+  void *ctx,
+  /// [in] Memory to resize, NULL to allocate
+  void *memory,
+  /// [in] New size, 0 to release
+  size_t size)
+{
+  (void)ctx;
+  if(size == 0) {
+    free(memory);
+    return NULL;
+  }
+  if(testAllocFailAfter >= 0 && testAllocFailAfter-- == 0) {
+    return NULL;
+  }
+  testAllocations++;
+  return realloc(memory, size);
+}
+
+/**********************************************************************************************************************/
+/** Print through TinyPrintfSpan()
+ **********************************************************************************************************************/
+static int TestPrintfSpan(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void *ctx,
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int pc;
+
+  va_start(va, format);
+  pc = TinyPrintfSpan(printspan, ctx, format, va);
+  va_end(va);
+
+  return pc;
+}
+
+#ifdef TINY_PRINTF_FLOAT
+/**********************************************************************************************************************/
+/** Floating point conversions, the expected strings are those of glibc
+ **********************************************************************************************************************/
+static void TestFloat(void)
+{
+  unsigned long long int x = 0x9E3779B97F4A7C15ull;
+  char string[64];
+  double value, parsed;
+  int i;
+
+  if(sizeof(TINY_PRINTF_FLOAT) != sizeof(double)) {
+    // The expected digits are those of double
+    return;
+  }
+
+  // Beyond 32 bits and precision beyond 9 digits
+  TEST_PRINTF("4294967296.000000", "%f", 4294967296.0);
+  TEST_PRINTF("4294967296.500000", "%f", 4294967296.5);
+  TEST_PRINTF("18446744073709551616.000", "%.3f", 18446744073709551616.0);
+  TEST_PRINTF("10000000000000000000000.000000", "%f", 1e22);
+  TEST_PRINTF("99999999999999991611392.000000", "%f", 1e23);
+  TEST_PRINTF("1.000000e+23", "%e", 1e23);
+  TEST_PRINTF("0.10000000000000000555", "%.20f", 0.1);
+  TEST_PRINTF("3.33333333333333315e-01", "%.17e", 1.0 / 3);
+  TEST_PRINTF("0.1", "%.15g", 0.1);
+  TEST_PRINTF("0.10000000000000001", "%.17g", 0.1);
+  TEST_PRINTF("0.666666666667", "%.12f", 2.0 / 3);
+
+  // Ties round to even, other values by their exact binary value
+  TEST_PRINTF("0", "%.0f", 0.5);
+  TEST_PRINTF("2", "%.0f", 1.5);
+  TEST_PRINTF("2", "%.0f", 2.5);
+  TEST_PRINTF("4", "%.0f", 3.5);
+  TEST_PRINTF("-2", "%.0f", -2.5);
+  TEST_PRINTF("0.2", "%.1f", 0.25);
+  TEST_PRINTF("0.3", "%.1f", 0.35);
+  TEST_PRINTF("1.00", "%.2f", 1.005);
+  TEST_PRINTF("2e+00", "%.0e", 2.5);
+  TEST_PRINTF("1.2e+00", "%.1e", 1.25);
+  TEST_PRINTF("2.67", "%.3g", 2.675);
+  TEST_PRINTF("1.000", "%.3f", 0.9999);
+
+  // Subnormals and the limits
+  TEST_PRINTF("4.940656e-324", "%e", 4.9406564584124654e-324);
+  TEST_PRINTF("4.94065645841246544177e-324", "%.20e", 4.9406564584124654e-324);
+  TEST_PRINTF("2.23e-308", "%.3g", 2.2250738585072009e-308);
+  TEST_PRINTF("9.99989e-321", "%g", 1e-320);
+  TEST_PRINTF("2.225074e-308", "%e", DBL_MIN);
+  TEST_PRINTF(
+    "1797693134862315708145274237317043567980705675258449965989174768031572607800285387605895586327668781"
+    "7154045895351438246423432132688946418276846754670353751698604991057655128207624549009038932894407586"
+    "8508455133942304583236903222948165808559332123348274797826204144723168738177180919299881250404026184"
+    "124858368.000000", "%f", DBL_MAX);
+  TEST_PRINTF("1.797693e+308", "%e", DBL_MAX);
+  TEST_PRINTF("1.79769e+308", "%g", DBL_MAX);
+
+  // Infinity and not a number with signs and flags, never padded with zeros
+  TEST_PRINTF("inf", "%f", INFINITY);
+  TEST_PRINTF("INF", "%F", INFINITY);
+  TEST_PRINTF("+inf", "%+f", INFINITY);
+  TEST_PRINTF("inf   |", "%-6f|", INFINITY);
+  TEST_PRINTF("  -inf", "%06f", -INFINITY);
+  TEST_PRINTF(" nan", "% e", NAN);
+  TEST_PRINTF("-NAN", "%E", -NAN);
+  TEST_PRINTF("+nan", "%+g", NAN);
+  TEST_PRINTF("  nan", "%5.2f", NAN);
+
+  // Alternative form, %g style and flags
+  TEST_PRINTF("1.00000", "%#g", 1.0);
+  TEST_PRINTF("0.00000", "%#g", 0.0);
+  TEST_PRINTF("1.00", "%#.3g", 1.0);
+  TEST_PRINTF("1.23457e+08", "%#g", 123456789.0);
+  TEST_PRINTF("3.", "%#.0f", 3.0);
+  TEST_PRINTF("3.e+00", "%#.0e", 3.0);
+  TEST_PRINTF("100000", "%g", 100000.0);
+  TEST_PRINTF("1e+06", "%g", 1e6);
+  TEST_PRINTF("0.0001", "%g", 0.0001);
+  TEST_PRINTF("1e-05", "%g", 0.00001);
+  TEST_PRINTF("-0", "%g", -0.0);
+  TEST_PRINTF("-0.000000", "%f", -0.0);
+  TEST_PRINTF("0.000000e+00", "%e", 0.0);
+  TEST_PRINTF("+0003.14", "%+08.2f", 3.14159);
+  TEST_PRINTF("-3.142e+00|", "%-10.3e|", -3.14159);
+  TEST_PRINTF(" 2.000", "% .3f", 2.0);
+  TEST_PRINTF("-1.234e+03", "%010.3e", -1234.5);
+  TEST_PRINTF("1E-10", "%.3G", 1e-10);
+  TEST_PRINTF("       123.5|", "%12.4g|", 123.456);
+
+  // Shortest digits reading back as the same value
+  TEST_PRINTF("0.1", "%r", 0.1);
+  TEST_PRINTF("1e+23", "%r", 1e23);
+  TEST_PRINTF("5e-324", "%r", 4.9406564584124654e-324);
+  TEST_PRINTF("1.5e-323", "%r", 1.5e-323);
+  TEST_PRINTF("2.2250738585072014e-308", "%r", DBL_MIN);
+  TEST_PRINTF("1.7976931348623157e+308", "%r", DBL_MAX);
+  TEST_PRINTF("1.2345678901234568e+17", "%r", 1.2345678901234568e17);
+  TEST_PRINTF("10000000000000000", "%r", 1e16);
+  TEST_PRINTF("0.3333333333333333", "%r", 1.0 / 3);
+  TEST_PRINTF("6.666666666666667e-06", "%r", 2.0 / 3 * 1e-5);
+  TEST_PRINTF("123456.789", "%r", 123456.789);
+  TEST_PRINTF("-0", "%r", -0.0);
+  TEST_PRINTF("1.5         |+2|", "%-12r|%+r|", 1.5, 2.0);
+  for(i = 0; i < 100000; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    memcpy(&value, &x, sizeof(value));
+    if(isnan(value) || isinf(value)) {
+      continue;
+    }
+    TinySNprintf(string, sizeof(string), "%r", value);
+    parsed = strtod(string, NULL);
+    if(memcmp(&parsed, &value, sizeof(value)) != 0) {
+      printf("%s:%d: %%r of %.17g reads back as %.17g\n", __FILE__, __LINE__, value, parsed);
+      testFailures++;
+      break;
+    }
+  }
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Output of TinyFormatStep() in chunks of any size is the same as of TinyFormatExecArgs()
+ **********************************************************************************************************************/
+static void TestStepFormat(
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  const TinyFormatArg *args)
+{
+  TinyFormatOp ops[16];
+  TinyFormat compiled;
+  TinyFormatState state, moved;
+  TinyBuilder whole, chunked;
+  char chunk[200];
+  size_t size, n;
+
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 16, format) > 0);
+  TinyBuilderInit(&whole, TestReallocate, NULL);
+  TinyBuilderInit(&chunked, TestReallocate, NULL);
+  TinyFormatExecArgs(&compiled, TinyBuilderSpan, &whole, args);
+
+  for(size = 1; size <= sizeof(chunk); size += (size < 70) ? 1 : 43) {
+    TinyBuilderReset(&chunked);
+    TinyFormatStart(&state, &compiled, args);
+    while((n = TinyFormatStep(&state, chunk, size)) != 0) {
+      TEST_CHECK(n <= size);
+      TinyBuilderSpan(&chunked, chunk, n);
+      // The state can be copied between steps
+      moved = state;
+      memset(&state, 0x55, sizeof(state));
+      state = moved;
+    }
+    if(chunked.length != whole.length || (whole.length != 0 && memcmp(chunked.string, whole.string, whole.length))) {
+      printf("%s:%d: chunks of %u bytes differ for \"%s\"\n", __FILE__, __LINE__, (unsigned)size, format);
+      testFailures++;
+      break;
+    }
+  }
+
+  TinyBuilderFree(&whole);
+  TinyBuilderFree(&chunked);
+}
+
+/// Calls of TestConvertCounted()
+static int testConvertCalls;
+
+/**********************************************************************************************************************/
+/** Custom conversion counting its calls, prints the precision number of letters padded to the width
+ **********************************************************************************************************************/
+static int TestConvertCounted(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion (unused)
+  const TinyFormatArg *arg)
+{
+  static const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+  int pc = 0, n = op->precision;
+
+  (void)arg;
+  testConvertCalls++;
+  if(n + 1 < op->width && !(op->options & TINY_FORMAT_PAD_RIGHT)) {
+    pc += TinyFormatPadded(printspan, ctx, "", 0, op->width - n, 0);
+  }
+  while(n > 0) {
+    int chunk = (n < 26) ? n : 26;
+    printspan(ctx, letters, chunk);
+    pc += chunk;
+    n -= chunk;
+  }
+  if(pc < op->width) {
+    pc += TinyFormatPadded(printspan, ctx, "", 0, op->width - pc, 0);
+  }
+
+  return pc;
+}
+
+/// Output collected by TestRecordSpan() and TestRecordChar()
+typedef struct {
+  /// Characters, null terminated
+  char string[256];
+  /// Number of characters
+  size_t length;
+  /// Number of calls
+  int calls;
+} TestRecord;
+
+/**********************************************************************************************************************/
+/** printspan function recording the spans
+ **********************************************************************************************************************/
+static void TestRecordSpan(
+  /// [in] Pointer to the record
+  void *ctx,
+  /// [in] Characters to print
+  const char *string,
+  /// [in] Number of characters to print
+  size_t length)
+{
+  TestRecord *record = ctx;
+
+  if(length < sizeof(record->string) - record->length) {
+    memcpy(record->string + record->length, string, length);
+    record->length += length;
+    record->string[record->length] = '\0';
+  }
+  record->calls++;
+}
+
+/**********************************************************************************************************************/
+/** printchar function recording the characters
+ **********************************************************************************************************************/
+static void TestRecordChar(
+  /// [in] Pointer to the record
+  void *ctx,
+  /// [in] Character to print
+  char c)
+{
+  TestRecordSpan(ctx, &c, 1);
+}
+
+/**********************************************************************************************************************/
+/** Print through TinyPrintf()
+ **********************************************************************************************************************/
+static int TestPrintfChar(
+  /// [in] printchar function pointer
+  printchar_t printchar,
+  /// [in] context for printchar function
+  void *ctx,
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int pc;
+
+  va_start(va, format);
+  pc = TinyPrintf(printchar, ctx, format, va);
+  va_end(va);
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** The printspan sink receives literal runs, padding and values as whole spans, the printchar sink the same text
+ **********************************************************************************************************************/
+static void TestSpanSink(void)
+{
+  TestRecord spans, chars;
+
+  memset(&spans, 0, sizeof(spans));
+  memset(&chars, 0, sizeof(chars));
+  TEST_CHECK(TestPrintfSpan(TestRecordSpan, &spans, "name: %s, value: %d\n", "abc", 12345) == 24);
+  TEST_STRING(spans.string, "name: abc, value: 12345\n");
+  // "name: ", "abc", ", value: ", "12345", "\n"
+  TEST_CHECK(spans.calls == 5);
+  TEST_CHECK(TestPrintfChar(TestRecordChar, &chars, "name: %s, value: %d\n", "abc", 12345) == 24);
+  TEST_STRING(chars.string, spans.string);
+  TEST_CHECK(chars.calls == 24);
+
+  // Padding comes in chunks, not per character
+  memset(&spans, 0, sizeof(spans));
+  TEST_CHECK(TestPrintfSpan(TestRecordSpan, &spans, "%40s|%%", "x") == 42);
+  TEST_CHECK(spans.length == 42 && spans.calls < 8);
+  TEST_CHECK(strcmp(spans.string + 38, " x|%") == 0);
+
+  // Unknown conversions print nothing, a lone '%' at the end is dropped
+  memset(&spans, 0, sizeof(spans));
+  TEST_CHECK(TestPrintfSpan(TestRecordSpan, &spans, "a%yb%") == 2);
+  TEST_STRING(spans.string, "ab");
+}
+
+/**********************************************************************************************************************/
+/** Print through TinyFormatExec()
+ **********************************************************************************************************************/
+static int TestFormatExec(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [out] Record of the output
+  TestRecord *record,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int pc;
+
+  memset(record, 0, sizeof(*record));
+  va_start(va, record);
+  pc = TinyFormatExec(compiled, TestRecordSpan, record, va);
+  va_end(va);
+
+  return pc;
+}
+
+/**********************************************************************************************************************/
+/** Fetch arguments through TinyFormatFetchArgs()
+ **********************************************************************************************************************/
+static int TestFormatFetch(
+  /// [in] Compiled format
+  const TinyFormat *compiled,
+  /// [out] Fetched arguments
+  TinyFormatArg *fetched,
+  /// [in] Number of arguments the array can hold
+  int maxArgs,
+  /// [in] Format arguments
+  ...)
+{
+  va_list va;
+  int count;
+
+  va_start(va, maxArgs);
+  count = TinyFormatFetchArgs(compiled, fetched, maxArgs, va);
+  va_end(va);
+
+  return count;
+}
+
+/**********************************************************************************************************************/
+/** A compiled format prints what TinySNprintf() prints, with variadic as well as with fetched arguments
+ **********************************************************************************************************************/
+static void TestCompile(void)
+{
+  static const char format[] = "x=%d y=%-5s|%*x%% end";
+  TinyFormatOp ops[5];
+  TinyFormat compiled;
+  TinyFormatArg args[4];
+  TestRecord record;
+  char expected[64];
+  int i;
+
+  // "x=" %d, " y=" %-5s, "|" %*x, "%", " end"
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 4, format) == -1);
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 5, format) == 5);
+  TEST_CHECK(compiled.count == 5);
+  TEST_CHECK(TinyFormatGetArgCount(&ops[0]) == 1 && TinyFormatGetArgType(&ops[0]) == TINY_ARG_INT);
+  TEST_CHECK(TinyFormatGetArgCount(&ops[1]) == 1 && TinyFormatGetArgType(&ops[1]) == TINY_ARG_STRING);
+  TEST_CHECK(TinyFormatGetArgCount(&ops[2]) == 2);
+  TEST_CHECK(TinyFormatGetArgCount(&ops[3]) == 0 && TinyFormatGetArgCount(&ops[4]) == 0);
+
+  // The compiled format is used many times
+  for(i = -3; i < 300; i += 7) {
+    TinySNprintf(expected, sizeof(expected), format, i, "ab", i % 9, i * 31);
+    TEST_CHECK(TestFormatExec(&compiled, &record, i, "ab", i % 9, i * 31) == (int)strlen(expected));
+    TEST_STRING(record.string, expected);
+  }
+  TEST_STRING(record.string, "x=298 y=ab   |2416% end");
+
+  TEST_CHECK(TestFormatFetch(&compiled, args, 3, 1, "cd", -4, 255) == -1);
+  TEST_CHECK(TestFormatFetch(&compiled, args, 4, 1, "cd", -4, 255) == 4);
+  memset(&record, 0, sizeof(record));
+  TEST_CHECK(TinyFormatExecArgs(&compiled, TestRecordSpan, &record, args) == 21);
+  TEST_STRING(record.string, "x=1 y=cd   |ff  % end");
+
+  // An empty format compiles to no operations
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 0, "") == 0);
+  TEST_CHECK(TestFormatExec(&compiled, &record) == 0 && record.calls == 0);
+
+#ifdef TINY_PRINTF_FORMAT_CACHE
+  // Cached formats take new arguments every call, formats too long for the cache are parsed directly
+  for(i = 0; i < 3; ++i) {
+    TEST_PRINTF(i == 0 ? "[0]" : i == 1 ? "[1]" : "[2]", "[%d]", i);
+  }
+  TEST_PRINTF("0123456789abcdefgh", "%d%d%d%d%d%d%d%d%d%d%x%x%x%x%x%x%c%c", 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+              13, 14, 15, 'g', 'h');
+#endif
+}
+
+/**********************************************************************************************************************/
+/** TinyPrintfLength(), TinySNprintf() without buffer and TinyASprintf() agree with the printed output
+ **********************************************************************************************************************/
+static void TestMeasureFormat(
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  ...)
+{
+  TestRecord record;
+  va_list va, ap;
+  char *string;
+  int length;
+
+  memset(&record, 0, sizeof(record));
+  va_start(va, format);
+  va_copy(ap, va);
+  length = TinyPrintfSpan(TestRecordSpan, &record, format, ap);
+  va_end(ap);
+  TEST_CHECK(length == (int)record.length);
+  va_copy(ap, va);
+  TEST_CHECK(TinyPrintfLength(format, ap) == length);
+  va_end(ap);
+  va_copy(ap, va);
+  TEST_CHECK(TinyVSNprintf(NULL, 0, format, ap) == length);
+  va_end(ap);
+
+  testAllocations = 0;
+  va_copy(ap, va);
+  TEST_CHECK(TinyVASprintf(&string, TestReallocate, NULL, format, ap) == length);
+  va_end(ap);
+  TEST_CHECK(testAllocations == 1);
+  TEST_STRING(string, record.string);
+  TestReallocate(NULL, string, 0);
+  va_end(va);
+}
+
+/**********************************************************************************************************************/
+/** Measuring without printing
+ **********************************************************************************************************************/
+static void TestMeasure(void)
+{
+  static const char *const formats[] = {
+    "%d", "%u", "%x", "%X", "%-12d|", "%012d", "%+d", "% d", "%5u", "%.0d", "%.7x", "%+.3d", "%#x", "%k", "%.3k", "%#k",
+    "%+9.2k", "%-7k|", "%c"
+  };
+  static const int values[] = { 0, 1, -1, 9, 10, -10, 99, 1000, 65535, 123456789, INT_MAX, INT_MIN };
+  char *string;
+  int i, f;
+
+  for(f = 0; f < (int)(sizeof(formats) / sizeof(formats[0])); f++) {
+    for(i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+      TestMeasureFormat(formats[f], values[i]);
+    }
+  }
+#ifdef TINY_PRINTF_LONG_LONG
+  TestMeasureFormat("%lld|%llu|%llx|%+lld|%.3llk", LLONG_MIN, ULLONG_MAX, 0x100000000ll, 0ll, -1234567ll);
+#endif
+  TestMeasureFormat("[%s|%10s|%-4s|%.2s|%*.*s]", "text", "right", "l", "cut", -6, 1, "xyz");
+  TestMeasureFormat("%s and %p", (const char *)NULL, (void *)&string);
+  TestMeasureFormat("100%% literal text");
+#ifdef TINY_PRINTF_FLOAT
+  TestMeasureFormat("%f %e %g %.0f %#.3g %r", 3.14159, -2.5e-300, 1e21, 0.5, 100.0, 0.1);
+#endif
+
+  // Nothing is allocated when the allocation fails
+  testAllocFailAfter = 0;
+  TEST_CHECK(TinyASprintf(&string, TestReallocate, NULL, "%d", 42) == -1 && string == NULL);
+  testAllocFailAfter = -1;
+}
+
+/**********************************************************************************************************************/
+/** TinySNprintf() prints what the span engine prints and truncates it like snprintf() for every buffer size
+ **********************************************************************************************************************/
+static void TestTruncateFormat(
+  /// [in] Format string
+  const char *format,
+  /// [in] Format arguments
+  ...)
+{
+  TestRecord record;
+  char string[160];
+  va_list va, ap;
+  int size, length;
+
+  memset(&record, 0, sizeof(record));
+  va_start(va, format);
+  va_copy(ap, va);
+  length = TinyPrintfSpan(TestRecordSpan, &record, format, ap);
+  va_end(ap);
+
+  for(size = 0; size <= length + 2 && size < (int)sizeof(string); size++) {
+    // Bytes behind the buffer must stay untouched
+    memset(string, '#', sizeof(string));
+    va_copy(ap, va);
+    TEST_CHECK(TinyVSNprintf(size ? string : NULL, size, format, ap) == length);
+    va_end(ap);
+    if(size > 0) {
+      int kept = (size - 1 < length) ? size - 1 : length;
+      TEST_CHECK(memcmp(string, record.string, kept) == 0 && string[kept] == '\0');
+    }
+    TEST_CHECK(string[size] == '#');
+  }
+  va_end(va);
+}
+
+/**********************************************************************************************************************/
+/** Sized buffer output
+ **********************************************************************************************************************/
+static void TestTruncate(void)
+{
+  static unsigned char bytes[] = { 0x00, 0x12, 0xab, 0xff, 0x7f };
+  char string[8], expected[8];
+  int size;
+
+  TestTruncateFormat("literal only");
+  TestTruncateFormat("%d|%-6u|%08x|%c|%%|% d", -12345, 77u, 0xbeefu, 'z', 5);
+  TestTruncateFormat("[%20s][%-8.3s][%s]", "right", "left", (const char *)NULL);
+  TestTruncateFormat("%p %.3k %ph", (void *)bytes, 123456, 5, bytes);
+#ifdef TINY_PRINTF_LONG_LONG
+  TestTruncateFormat("%lld %llx", LLONG_MIN, 0xfedcba9876543210ull);
+#endif
+#ifdef TINY_PRINTF_FLOAT
+  TestTruncateFormat("%f|%12.4e|%-10g|%r", -1.0 / 3, 6.02e23, 1e-5, 2.0 / 3);
+#endif
+
+  // Same return values and contents as the C library
+  for(size = 0; size <= (int)sizeof(string); size++) {
+    memset(string, 0, sizeof(string));
+    memset(expected, 0, sizeof(expected));
+    TEST_CHECK(TinySNprintf(string, size, "%d-%s", 1234, "ab") == snprintf(expected, size, "%d-%s", 1234, "ab"));
+    TEST_CHECK(memcmp(string, expected, sizeof(string)) == 0);
+  }
+}
+
+/**********************************************************************************************************************/
+/** Custom conversion printing its int argument in brackets, respecting width and flags
+ **********************************************************************************************************************/
+static int TestConvertBracket(
+  /// [in] printspan function pointer
+  printspan_t printspan,
+  /// [in] context for printspan function
+  void* ctx,
+  /// [in] Conversion
+  const TinyFormatOp *op,
+  /// [in] Argument of the conversion
+  const TinyFormatArg *arg)
+{
+  char string[32];
+  int length;
+
+#ifdef TINY_PRINTF_LONG_LONG
+  if(op->options & TINY_FORMAT_LONG_LONG) {
+    length = TinySNprintf(string, sizeof(string), "<%lld>", arg->ll);
+    return TinyFormatPadded(printspan, ctx, string, length, op->width, op->options);
+  }
+#endif
+  length = TinySNprintf(string, sizeof(string), "<%d>", arg->i);
+  return TinyFormatPadded(printspan, ctx, string, length, op->width, op->options);
+}
+
+/**********************************************************************************************************************/
+/** Registered conversions are dispatched like the builtin ones
+ **********************************************************************************************************************/
+static void TestRegister(void)
+{
+  TEST_CHECK(TinyFormatRegister('d', TINY_ARG_INT, TestConvertBracket) == -1);
+  TEST_CHECK(TinyFormatRegister('*', TINY_ARG_INT, TestConvertBracket) == -1);
+  TEST_CHECK(TinyFormatRegister('l', TINY_ARG_INT, TestConvertBracket) == -1);
+  TEST_CHECK(TinyFormatRegister('B', TINY_ARG_INT, NULL) == -1);
+  TEST_CHECK(TinyFormatRegister('B', TINY_ARG_INT, TestConvertBracket) == 0);
+  TEST_CHECK(TinyFormatRegister('B', TINY_ARG_INT, TestConvertBracket) == -1);
+
+  TEST_PRINTF("x<42>y<-1>|  <7>|<7>  |", "x%By%B|%5B|%-5B|", 42, -1, 7, 7);
+  TEST_PRINTF("  <3>", "%*B", 5, 3);
+#ifdef TINY_PRINTF_LONG_LONG
+  TEST_PRINTF("<-9223372036854775808>", "%llB", LLONG_MIN);
+#endif
+  TEST_CHECK(TinySNprintf(NULL, 0, "%5B%B", 1, 1000) == 11);
+}
+
+/**********************************************************************************************************************/
+/** Integer conversions match the C library around every digit count boundary
+ **********************************************************************************************************************/
+static void TestInteger(void)
+{
+  static const char *const formats[] = {
+    "%d", "%u", "%x", "%X", "%-12d|", "%012d", "%+d", "% d", "%5u", "%08X", "%1d", "%+012d", "% 05d"
+  };
+#ifdef TINY_PRINTF_LONG_LONG
+  static const char *const formatsLongLong[] = {
+    "%lld", "%llu", "%llx", "%llX", "%-24lld|", "%024lld", "%+lld", "% lld", "%020llu"
+  };
+#endif
+  long long int values[128];
+  unsigned long long int power;
+  char string[64], expected[64];
+  int count = 0, i, f;
+
+  values[count++] = 0;
+  values[count++] = -1;
+  values[count++] = INT_MAX;
+  values[count++] = INT_MIN;
+  values[count++] = UINT_MAX;
+  values[count++] = LLONG_MAX;
+  values[count++] = LLONG_MIN;
+  for(power = 1; power < ULLONG_MAX / 10; power *= 10) {
+    values[count++] = (long long int)power - 1;
+    values[count++] = (long long int)power;
+    values[count++] = -(long long int)power;
+  }
+  for(i = 0; i < 64; i += 4) {
+    values[count++] = (long long int)(1ull << i);
+    values[count++] = (long long int)((1ull << i) - 1);
+  }
+
+  for(i = 0; i < count; i++) {
+    for(f = 0; f < (int)(sizeof(formats) / sizeof(formats[0])); f++) {
+      TinySNprintf(string, sizeof(string), formats[f], (int)values[i]);
+      snprintf(expected, sizeof(expected), formats[f], (int)values[i]);
+      TEST_STRING(string, expected);
+    }
+#ifdef TINY_PRINTF_LONG_LONG
+    for(f = 0; f < (int)(sizeof(formatsLongLong) / sizeof(formatsLongLong[0])); f++) {
+      TinySNprintf(string, sizeof(string), formatsLongLong[f], values[i]);
+      snprintf(expected, sizeof(expected), formatsLongLong[f], values[i]);
+      TEST_STRING(string, expected);
+    }
+#endif
+  }
+
+  TEST_PRINTF("-2147483648|4294967295|ffffffff|7FFFFFFF", "%d|%u|%x|%X", INT_MIN, UINT_MAX, -1, INT_MAX);
+  TEST_PRINTF("-000042|+42| 42|42    |", "%07d|%+d|% d|%-6d|", -42, 42, 42, 42);
+  TEST_PRINTF("%|c|", "%%|%c|", 'c');
+  TEST_PRINTF((sizeof(void *) == 8) ? "000000001234ABCD" : "1234ABCD", "%p", (void *)(size_t)0x1234ABCD);
+}
+
+/**********************************************************************************************************************/
+/** String precisions bound the characters read, negative '*' precisions count as omitted
+ **********************************************************************************************************************/
+static void TestStringPrecision(void)
+{
+  char *letters = malloc(5), *string;
+  TestRecord record;
+  int precision;
+
+  if(letters == NULL) {
+    TEST_CHECK(letters != NULL);
+    return;
+  }
+  // Not null terminated, reading behind it is caught by address sanitizers
+  memcpy(letters, "abcde", 5);
+
+  TEST_PRINTF("abc|abcde|   ab|a  |", "%.3s|%.5s|%5.2s|%-3.1s|", letters, letters, letters, letters);
+  for(precision = 0; precision <= 5; precision++) {
+    char expected[8];
+    memcpy(expected, letters, precision);
+    expected[precision] = '\0';
+    TEST_PRINTF(expected, "%.*s", precision, letters);
+    TEST_CHECK(TinySNprintf(NULL, 0, "%.*s", precision, letters) == precision);
+    memset(&record, 0, sizeof(record));
+    TEST_CHECK(TestPrintfSpan(TestRecordSpan, &record, "%*.*s", -7, precision, letters) == 7);
+    TEST_CHECK(strncmp(record.string, letters, precision) == 0 && strlen(record.string) == 7);
+  }
+  testAllocations = 0;
+  TEST_CHECK(TinyASprintf(&string, TestReallocate, NULL, "[%.4s]", letters) == 6);
+  if(string != NULL) {
+    TEST_STRING(string, "[abcd]");
+    TestReallocate(NULL, string, 0);
+  }
+  free(letters);
+
+  // A terminator within the precision ends the string, a negative precision means none
+  TEST_PRINTF("ab|ab|abcdef|    abcdef", "%.5s|%.*s|%.*s|%*.*s", "ab", 9, "ab", -1, "abcdef", 10, -3, "abcdef");
+  TEST_PRINTF("(nu|(null)", "%.3s|%.*s", (const char *)NULL, -2, (const char *)NULL);
+}
+
+/**********************************************************************************************************************/
+/** Hex dump of a buffer built with snprintf() for comparison
+ **********************************************************************************************************************/
+static void TestHexReference(
+  /// [out] Expected dump
+  char *expected,
+  /// [in] Bytes to dump
+  const unsigned char *bytes,
+  /// [in] Number of bytes to dump
+  int length,
+  /// [in] Separator, '\0' for none
+  char separator,
+  /// [in] Bytes per group
+  int group,
+  /// [in] Use uppercase digits
+  int upper)
+{
+  int i;
+
+  for(i = 0; i < length; i++) {
+    if(separator != '\0' && i != 0 && i % group == 0) {
+      *expected++ = separator;
+    }
+    expected += snprintf(expected, 3, upper ? "%02X" : "%02x", bytes[i]);
+  }
+  *expected = '\0';
+}
+
+/**********************************************************************************************************************/
+/** Hex dumps
+ **********************************************************************************************************************/
+static void TestHexDump(void)
+{
+  static unsigned char bytes[700];
+  static char string[2200], expected[2200];
+  int i, length;
+
+  for(i = 0; i < (int)sizeof(bytes); i++) {
+    bytes[i] = (unsigned char)(i * 37 + (i >> 3));
+  }
+
+  TEST_PRINTF("0012abff", "%*ph", 4, "\x00\x12\xab\xff");
+  TEST_PRINTF("0012ABFF", "%4pH", "\x00\x12\xab\xff");
+  TEST_PRINTF("00:12:ab:ff|00-12-ab-ff|00 12 ab ff|0012abff", "%4phC|%4phD|%4phS|%4phN", "\x00\x12\xab\xff",
+              "\x00\x12\xab\xff", "\x00\x12\xab\xff", "\x00\x12\xab\xff");
+  TEST_PRINTF("0012:abff:01", "%*.2phC", 5, "\x00\x12\xab\xff\x01");
+  TEST_PRINTF("0012abff01", "%*.2ph", 5, "\x00\x12\xab\xff\x01");
+  TEST_PRINTF("[]", "[%*ph]", 0, "\x01");
+  TEST_PRINTF("[]", "[%*phC]", -3, "\x01");
+  TEST_PRINTF("[(null)]", "[%*ph]", 3, (const void *)NULL);
+  TEST_PRINTF("[ab]h", "[%*ph]%c", 1, "\xab", 'h');
+
+  // Long dumps span several internal buffers, compare every length around the buffer size
+  for(length = 1; length <= (int)sizeof(bytes); length += (length < 140) ? 1 : 37) {
+    TinySNprintf(string, sizeof(string), "%*ph", length, bytes);
+    TestHexReference(expected, bytes, length, '\0', 1, 0);
+    TEST_STRING(string, expected);
+    TinySNprintf(string, sizeof(string), "%*pHS", length, bytes);
+    TestHexReference(expected, bytes, length, ' ', 1, 1);
+    TEST_STRING(string, expected);
+    TinySNprintf(string, sizeof(string), "%*.3phC", length, bytes);
+    TestHexReference(expected, bytes, length, ':', 3, 0);
+    TEST_STRING(string, expected);
+    TEST_CHECK(TinySNprintf(NULL, 0, "%*.16phD", length, bytes) == length * 2 + (length - 1) / 16);
+  }
+}
+
+/// Record of TestBatch()
+typedef struct {
+  /// Row number
+  int number;
+  /// Unsigned byte
+  unsigned char byte;
+  /// Name (pointer)
+  const char *name;
+  /// Code, not null terminated
+  char code[4];
+  /// Big unsigned value
+  unsigned long long int big;
+  /// Floating point value
+  double value;
+} TestBatchRecord;
+
+/**********************************************************************************************************************/
+/** Batch formatting writes complete rows only and continues where it stopped
+ **********************************************************************************************************************/
+static void TestBatch(void)
+{
+  static const char format[] = "%d;%5u;%-6s;%.4s\n";
+  static const TinyFormatField fields[] = {
+    { offsetof(TestBatchRecord, number), TINY_FIELD_INT },
+    { offsetof(TestBatchRecord, byte), TINY_FIELD_UCHAR },
+    { offsetof(TestBatchRecord, name), TINY_FIELD_STRING },
+    { offsetof(TestBatchRecord, code), TINY_FIELD_CHARS }
+  };
+  static const char *const names[] = { "a", "bb", "cccccccc", "dddd" };
+  TestBatchRecord records[50];
+  TinyFormatOp ops[5];
+  TinyFormat compiled;
+  TinyBuilder expected, joined;
+  size_t offsets[51];
+  char buf[200];
+  int i, size, done, rows;
+
+  memset(records, 0, sizeof(records));
+  TinyBuilderInit(&expected, TestReallocate, NULL);
+  for(i = 0; i < 50; i++) {
+    records[i].number = i * 997 - 20000;
+    records[i].byte = (unsigned char)(i * 41);
+    records[i].name = names[i % 4];
+    memcpy(records[i].code, "WXYZ", 4);
+    records[i].code[i % 4] = (char)('0' + i % 10);
+    TinyBuilderPrintf(&expected, "%d;%5u;%-6s;%.4s\n", records[i].number, records[i].byte, records[i].name,
+                      records[i].code);
+  }
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 5, format) > 0);
+
+  // Everything fits
+  TEST_CHECK(TinyFormatBatch(&compiled, fields, records, sizeof(records[0]), 1, buf, sizeof(buf), offsets) == 1);
+  TEST_CHECK(offsets[0] == 0 && offsets[1] == (size_t)(strchr(expected.string, '\n') - expected.string + 1));
+  TEST_CHECK(memcmp(buf, expected.string, offsets[1]) == 0);
+
+  // Small buffers take several calls, each keeping complete rows only
+  for(size = 0; size <= (int)sizeof(buf); size += (size < 40) ? 1 : 23) {
+    TinyBuilderInit(&joined, TestReallocate, NULL);
+    for(done = 0; done < 50; done += rows) {
+      rows = TinyFormatBatch(&compiled, fields, records + done, sizeof(records[0]), 50 - done, buf, size, offsets);
+      if(rows == 0) {
+        break;
+      }
+      TEST_CHECK(offsets[0] == 0 && offsets[rows] <= (size_t)size);
+      for(i = 0; i < rows; i++) {
+        TEST_CHECK(offsets[i] < offsets[i + 1] && buf[offsets[i + 1] - 1] == '\n');
+      }
+      TinyBuilderSpan(&joined, buf, offsets[rows]);
+    }
+    if(done < 50) {
+      // Only a buffer too small for the next row stops early, nothing of that row is reported
+      TEST_CHECK(offsets[0] == 0 && size < 30);
+    }
+    else {
+      TEST_CHECK(joined.length == expected.length && memcmp(joined.string, expected.string, joined.length) == 0);
+    }
+    TinyBuilderFree(&joined);
+  }
+  TinyBuilderFree(&expected);
+
+#if defined(TINY_PRINTF_LONG_LONG) && defined(TINY_PRINTF_FLOAT)
+  {
+    static const char convert[] = "%llu %.0f %lld";
+    static const TinyFormatField converted[] = {
+      { offsetof(TestBatchRecord, big), TINY_FIELD_ULONG_LONG },
+      { offsetof(TestBatchRecord, big), TINY_FIELD_ULONG_LONG },
+      { offsetof(TestBatchRecord, value), TINY_FIELD_DOUBLE }
+    };
+    // Unsigned fields convert to double unsigned, floating point fields out of range saturate
+    records[0].big = ULLONG_MAX;
+    records[0].value = 1e300;
+    records[1].big = 1ull << 63;
+    records[1].value = -HUGE_VAL;
+    records[2].big = 12;
+    records[2].value = -2.75;
+    TEST_CHECK(TinyFormatCompile(&compiled, ops, 5, convert) > 0);
+    for(i = 0; i < 3; i++) {
+      rows = TinyFormatBatch(&compiled, converted, records + i, sizeof(records[0]), 1, buf, sizeof(buf) - 1, offsets);
+      TEST_CHECK(rows == 1);
+      buf[offsets[rows]] = '\0';
+      TEST_STRING(buf, (i == 0) ? "18446744073709551615 18446744073709551616 9223372036854775807" :
+                       (i == 1) ? "9223372036854775808 9223372036854775808 -9223372036854775808" : "12 12 -2");
+    }
+  }
+#endif
+}
+
+#ifdef TINY_PRINTF_TIMESTAMP
+/**********************************************************************************************************************/
+/** Check a timestamp against the C library, printing it twice to go through the cached second as well
+ **********************************************************************************************************************/
+static void TestTimestampSecond(
+  /// [in] Seconds since the epoch
+  time_t second)
+{
+  struct timespec time;
+  struct tm tm;
+  char string[64], expected[160];
+
+  time.tv_sec = second;
+  time.tv_nsec = 5000000;
+  if(gmtime_r(&second, &tm) == NULL) {
+    return;
+  }
+  snprintf(expected, sizeof(expected), "%04d-%02d-%02dT%02d:%02d:%02d.005Z|%04d%02d%02dT%02d%02d%02dZ",
+           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+  TinySNprintf(string, sizeof(string), "%.3T|%#T", &time, &time);
+  TEST_STRING(string, expected);
+  TinySNprintf(string, sizeof(string), "%.3T|%#T", &time, &time);
+  TEST_STRING(string, expected);
+}
+
+/**********************************************************************************************************************/
+/** Timestamps
+ **********************************************************************************************************************/
+static void TestTimestamp(void)
+{
+  struct timespec time;
+  long long int second;
+
+  time.tv_sec = 0;
+  time.tv_nsec = 0;
+  TEST_PRINTF("1970-01-01T00:00:00Z|19700101T000000Z", "%T|%#T", &time, &time);
+  time.tv_sec = 1715934600;
+  time.tv_nsec = 123456789;
+  TEST_PRINTF("2024-05-17T08:30:00.123Z|20240517T083000.1Z", "%.3T|%#.1T", &time, &time);
+  TEST_PRINTF("2024-05-17T08:30:00.123456789Z", "%.12T", &time);
+  TEST_PRINTF("   2024-05-17T08:30:00Z|2024-05-17T08:30:00Z   |", "%23T|%-23T|", &time, &time);
+  TEST_PRINTF("(null)", "%T", (const struct timespec *)NULL);
+#ifdef TINY_PRINTF_LONG_LONG
+  TEST_PRINTF("2024-05-17T08:30:00.123Z", "%.3llT", 1715934600123000000ll);
+  TEST_PRINTF("1969-12-31T23:59:59.999999999Z", "%.9llT", -1ll);
+#endif
+
+  // Seconds changing within the cached minute, day, year and leap day boundaries
+  for(second = 951782395; second < 951782405; second++) {
+    TestTimestampSecond((time_t)second);
+  }
+  for(second = 946684795; second < 946684805; second++) {
+    TestTimestampSecond((time_t)second);
+  }
+  // Spread over the years 0 to 9999, where the C library has them
+  for(second = -62167219200LL; second <= 253402300799LL; second += 157000003LL) {
+    if(sizeof(time_t) < 8 && (second < INT_MIN || second > INT_MAX)) {
+      continue;
+    }
+    TestTimestampSecond((time_t)second);
+  }
+
+  // Times out of the years 0 to 9999 stay within them, not normalized nanoseconds are cut
+  if(sizeof(time_t) >= 8) {
+    time.tv_sec = (time_t)-62167219201LL;
+    time.tv_nsec = 500;
+    TEST_PRINTF("0000-01-01T00:00:00.000Z", "%.3T", &time);
+    time.tv_sec = (time_t)253402300800LL;
+    TEST_PRINTF("9999-12-31T23:59:59.999Z|99991231T235959Z", "%.3T|%#T", &time, &time);
+    time.tv_sec = (time_t)LLONG_MIN;
+    TEST_PRINTF("0000-01-01T00:00:00Z", "%T", &time);
+  }
+  time.tv_sec = 0;
+  time.tv_nsec = 2000000000;
+  TEST_PRINTF("1970-01-01T00:00:00.99Z", "%.2T", &time);
+  TEST_CHECK(TinySNprintf(NULL, 0, "%.2T", &time) == 23);
+}
+#endif
+
+/**********************************************************************************************************************/
+/** Fixed point conversions, compared with %f of the scaled value (exact for the magnitudes used)
+ ***********************************************************************************************************************
+ *
+ * The formats are built at run time in one buffer, so they are compiled instead of going through the format cache.
+ *
+ **********************************************************************************************************************/
+static void TestFixed(void)
+{
+  static const char *const flags[] = { "", "-", "0", "+", " ", "#", "+0", "-+", "0#", " 0" };
+  static const int widths[] = { 0, 1, 6, 12, 25 };
+  static const int values[] = { 0, 1, -1, 5, -9, 10, 99, -100, 12345, -12345, 1000000, 999999999, INT_MAX, INT_MIN };
+  char format[32], reference[32], expected[64];
+  TinyFormatOp ops[2];
+  TinyFormat compiled;
+  TestRecord record;
+  int f, w, v, scale, i;
+  double divisor;
+
+  for(f = 0; f < (int)(sizeof(flags) / sizeof(flags[0])); f++) {
+    for(w = 0; w < (int)(sizeof(widths) / sizeof(widths[0])); w++) {
+      for(scale = 0; scale <= 12; scale += (scale < 4) ? 1 : 4) {
+        snprintf(format, sizeof(format), "%%%s%d.%dk|", flags[f], widths[w], scale);
+        TinyFormatCompile(&compiled, ops, 2, format);
+        snprintf(reference, sizeof(reference), "%%%s%d.%df|", flags[f], widths[w], scale);
+        for(divisor = 1, i = 0; i < scale; i++) {
+          divisor *= 10;
+        }
+        for(v = 0; v < (int)(sizeof(values) / sizeof(values[0])); v++) {
+          TestFormatExec(&compiled, &record, values[v]);
+          snprintf(expected, sizeof(expected), reference, values[v] / divisor);
+          TEST_STRING(record.string, expected);
+        }
+      }
+    }
+  }
+
+  // Without precision the integer is printed as is
+  TEST_PRINTF("12345|-7|12345.|  +42|-2147483648", "%k|%k|%#k|%+5k|%k", 12345, -7, 12345, 42, INT_MIN);
+  TEST_PRINTF("-21474836.48|0.00|-0.001|  1.5|1.5  |", "%.2k|%.2k|%.3k|%*.*k|%-*.1k|", INT_MIN, 0, -1, 5, 1, 15, 5,
+              15);
+#ifdef TINY_PRINTF_LONG_LONG
+  TEST_PRINTF("-9223372036854775808|-9.223372036854775808|9223372036.854775807", "%llk|%.18llk|%.9llk", LLONG_MIN,
+              LLONG_MIN, LLONG_MAX);
+  TEST_PRINTF("-0.0000000000000000000000001|+00001.000", "%.25llk|%+010.3llk", -1ll, 1000ll);
+#endif
+}
+
+/**********************************************************************************************************************/
+/** Incremental formatting
+ **********************************************************************************************************************/
+static void TestStep(void)
+{
+  static char letters[100001];
+  static unsigned char bytes[300];
+  TinyFormatArg args[8];
+  TinyFormatOp ops[5];
+  TinyFormat compiled;
+  TinyFormatState state;
+  char chunk[64];
+  size_t i, total;
+
+  for(i = 0; i < sizeof(letters) - 1; i++) {
+    letters[i] = (char)('a' + i % 26);
+  }
+  for(i = 0; i < sizeof(bytes); i++) {
+    bytes[i] = (i < 100) ? 0 : (unsigned char)(i * 7);
+  }
+
+  TestStepFormat("only literal text, 100%% of it", NULL);
+  args[0].s = "hello";
+  args[1].i = 42;
+  args[2].i = -42;
+  args[3].i = 0xBEEF;
+  args[4].i = 'c';
+  TestStepFormat("a%sb%-5d|%05d|%x%%%-20c|%c\n", args);
+  args[0].i = 300;
+  args[1].s = "right";
+  args[2].i = 300;
+  args[3].s = "left";
+  args[4].i = 3;
+  args[5].s = "truncated";
+  TestStepFormat("%*s|%-*s|%.*s|", args);
+  args[0].s = letters;
+  args[1].i = 2000;
+  args[2].i = 12;
+  args[3].i = 123456;
+  args[4].i = -2000;
+  args[5].i = 300;
+  args[6].i = 7;
+  TestStepFormat("%s%1000d|%*.3k|%-012.2k|%0*d", args);
+  args[0].i = 300;
+  args[1].p = bytes;
+  args[2].i = 300;
+  args[3].p = bytes;
+  args[4].i = 299;
+  args[5].p = bytes;
+  args[6].i = 300;
+  args[7].p = bytes;
+  TestStepFormat("%*ph|%*pHC|%*.4phS|%*.40phD|", args);
+  args[0].p = bytes + 100;
+  args[1].p = NULL;
+  TestStepFormat("%16ph|%8phC", args);
+#ifdef TINY_PRINTF_FLOAT
+  args[0].f = 0.1;
+  args[1].f = -1234.5678;
+  args[2].f = 4.9406564584124654e-324;
+  args[3].f = 1.7976931348623157e308;
+  args[4].f = 3.0;
+  TestStepFormat("%.60f|%-30e|%.1100f|%f|%+0200.3000f|", args);
+  args[0].f = 2.5;
+  args[1].f = -0.0;
+  args[2].f = 1e-300;
+  TestStepFormat("%g|%#20g|%r\n", args);
+#endif
+
+  // Conversions are converted once however small the chunks are, output beyond the text again every few characters
+  TEST_CHECK(TinyFormatRegister('Q', TINY_ARG_NONE, TestConvertCounted) == 0);
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 4, "%-1000000.5Q%.200Q") == 2);
+  for(i = 1; i <= sizeof(chunk); i *= 4) {
+    testConvertCalls = 0;
+    total = 0;
+    TinyFormatStart(&state, &compiled, NULL);
+    while((total += TinyFormatStep(&state, chunk, i)) % i == 0 && total < 1000200);
+    TEST_CHECK(total == 1000200);
+    TEST_CHECK(testConvertCalls == 1 + (200 + TINY_PRINTF_STEP_TEXT - 1) / TINY_PRINTF_STEP_TEXT);
+  }
+
+  // Long padding and strings in small chunks take linear time
+  args[0].i = 1 << 20;
+  args[1].s = "x";
+  args[2].s = letters;
+  TEST_CHECK(TinyFormatCompile(&compiled, ops, 4, "%*s%s") == 2);
+  TinyFormatStart(&state, &compiled, args);
+  for(total = 0; (i = TinyFormatStep(&state, chunk, sizeof(chunk))) != 0; total += i);
+  TEST_CHECK(total == (1 << 20) + sizeof(letters) - 1);
+}
+
+/**********************************************************************************************************************/
+/** A builder appends formatted output and spans, grows rarely and keeps its memory when reset
+ **********************************************************************************************************************/
+static void TestBuilder(void)
+{
+  static char large[1000];
+  TinyBuilder builder;
+  size_t first, size;
+
+  memset(large, 'x', sizeof(large) - 1);
+  testAllocations = 0;
+  TinyBuilderInit(&builder, TestReallocate, NULL);
+  TEST_CHECK(builder.string == NULL && builder.length == 0 && testAllocations == 0);
+
+  // Appends fill the first memory (TINY_PRINTF_BUILDER_SIZE, at least 20 bytes are assumed)
+  TEST_CHECK(TinyBuilderPrintf(&builder, "%s", "") == 0);
+  TEST_STRING(builder.string, "");
+  TEST_CHECK(TinyBuilderPrintf(&builder, "a=%d", 1) == 3);
+  TEST_CHECK(TinyBuilderPrintf(&builder, ", b=%-4s|", "x") == 9);
+  TEST_CHECK(TestPrintfSpan(TinyBuilderSpan, &builder, " %05x", 0xAB) == 6);
+  TinyBuilderSpan(&builder, "!", 1);
+  TEST_STRING(builder.string, "a=1, b=x   | 000ab!");
+  TEST_CHECK(builder.length == 19);
+  TEST_CHECK(builder.size > builder.length && testAllocations == 1);
+  first = builder.size;
+
+  // A long append grows once to at least double the size
+  TEST_CHECK(TinyBuilderPrintf(&builder, "[%s]", large) == sizeof(large) + 1);
+  TEST_CHECK(builder.length == 19 + sizeof(large) + 1 && testAllocations == 2);
+  TEST_CHECK(builder.size > builder.length && builder.size >= 2 * first && builder.size % first == 0);
+  TEST_CHECK(strncmp(builder.string, "a=1, b=x   | 000ab![xxx", 23) == 0);
+  TEST_CHECK(strcmp(builder.string + builder.length - 3, "xx]") == 0);
+  TEST_CHECK(TinyBuilderReserve(&builder, builder.size) == 0 && testAllocations == 3);
+
+  // Reset keeps the memory
+  size = builder.size;
+  TinyBuilderReset(&builder);
+  TEST_CHECK(builder.length == 0 && builder.size == size);
+  TEST_STRING(builder.string, "");
+  TEST_CHECK(TinyBuilderPrintf(&builder, "%s%s", large, large) == 2 * (int)(sizeof(large) - 1));
+  TEST_CHECK(testAllocations == 3);
+
+  TinyBuilderFree(&builder);
+  TEST_CHECK(builder.string == NULL && builder.length == 0 && builder.size == 0);
+  TEST_CHECK(TinyBuilderPrintf(&builder, "%d", 12) == 2);
+  TEST_STRING(builder.string, "12");
+  TinyBuilderFree(&builder);
+}
+
+/**********************************************************************************************************************/
+/** A builder drops everything after a failed grow until it is reset
+ **********************************************************************************************************************/
+static void TestBuilderError(void)
+{
+  static char large[4096];
+  TinyBuilder builder;
+
+  memset(large, 'x', sizeof(large) - 1);
+  TinyBuilderInit(&builder, TestReallocate, NULL);
+  TEST_CHECK(TinyBuilderPrintf(&builder, "%s", "ok") == 2);
+
+  // The grow for the long string fails, a short span would still fit into the old memory
+  testAllocFailAfter = 0;
+  TEST_CHECK(TinyBuilderPrintf(&builder, "%s", large) == -1);
+  TEST_CHECK(builder.error);
+  TinyBuilderSpan(&builder, "ab", 2);
+  TEST_CHECK(builder.length == 2);
+  TEST_CHECK(TinyBuilderPrintf(&builder, "%d", 1) == -1);
+  TEST_CHECK(TinyBuilderReserve(&builder, 1) == -1);
+  TEST_CHECK(builder.length == 2 && strcmp(builder.string, "ok") == 0);
+
+  TinyBuilderReset(&builder);
+  TinyBuilderSpan(&builder, "ab", 2);
+  TEST_CHECK(builder.length == 2 && strcmp(builder.string, "ab") == 0);
+  TinyBuilderFree(&builder);
+}
+
+#ifdef TINY_PRINTF_STATS
+/**********************************************************************************************************************/
+/** Calls, conversions, truncations and formats are counted, reset and dumped
+ **********************************************************************************************************************/
+static void TestStatsCount(void)
+{
+  static const char format[] = "%d:%s:%d";
+  TinyBuilder builder;
+  char string[8];
+  TinyStats stats;
+  int i;
+
+  TinyStatsReset();
+  TinyStatsSnapshot(&stats);
+  TEST_CHECK(stats.calls.count == 0 && stats.truncations == 0 && stats.conversions['d'].count == 0);
+
+  TEST_CHECK(TinySNprintf(string, sizeof(string), format, 1, "ab", 22) == 7);
+  TEST_CHECK(TinySNprintf(string, sizeof(string), format, 333, "cdef", 4) == 10);
+  TinyStatsSnapshot(&stats);
+  TEST_CHECK(stats.calls.count == 2 && stats.calls.bytes == 17);
+  TEST_CHECK(stats.truncations == 1);
+  TEST_CHECK(stats.conversions['d'].count == 4 && stats.conversions['d'].bytes == 7);
+  TEST_CHECK(stats.conversions['s'].count == 2 && stats.conversions['s'].bytes == 6);
+  for(i = 0; i < TINY_PRINTF_STATS_FORMATS && stats.formats[i].format != format; i++) {
+  }
+  TEST_CHECK(i < TINY_PRINTF_STATS_FORMATS);
+  if(i < TINY_PRINTF_STATS_FORMATS) {
+    TEST_CHECK(stats.formats[i].calls.count == 2 && stats.formats[i].calls.bytes == 17);
+  }
+
+  TinyBuilderInit(&builder, TestReallocate, NULL);
+  i = TinyStatsDump(TinyBuilderSpan, &builder, &stats);
+  TEST_CHECK(builder.error == 0 && i == (int)builder.length);
+  if(builder.string != NULL) {
+    TEST_CHECK(strstr(builder.string, "truncations") != NULL);
+    TEST_CHECK(strstr(builder.string, "conversion %d") != NULL);
+    TEST_CHECK(strstr(builder.string, "\"%d:%s:%d\"") != NULL);
+  }
+  TinyBuilderFree(&builder);
+
+  TinyStatsReset();
+  TinyStatsSnapshot(&stats);
+  TEST_CHECK(stats.calls.count == 0 && stats.truncations == 0 && stats.conversions['s'].count == 0);
+  for(i = 0; i < TINY_PRINTF_STATS_FORMATS; i++) {
+    TEST_CHECK(stats.formats[i].format == NULL);
+  }
+}
+
+/**********************************************************************************************************************/
+/** An append growing the builder counts as one call without truncation
+ **********************************************************************************************************************/
+static void TestStatsBuilderGrow(void)
+{
+  static const char format[] = "%s";
+  static char large[1000];
+  TinyBuilder builder;
+  TinyStats stats;
+
+  memset(large, 'x', sizeof(large) - 1);
+  TinyBuilderInit(&builder, TestReallocate, NULL);
+  TinyStatsReset();
+  TEST_CHECK(TinyBuilderPrintf(&builder, format, large) == sizeof(large) - 1);
+  TinyStatsSnapshot(&stats);
+  TEST_CHECK(stats.calls.count == 1);
+  TEST_CHECK(stats.calls.bytes == sizeof(large) - 1);
+  TEST_CHECK(stats.truncations == 0);
+  TEST_CHECK(stats.conversions['s'].count == 1);
+  TEST_CHECK(stats.conversions['s'].bytes == sizeof(large) - 1);
+  TinyBuilderFree(&builder);
+}
+
+/**********************************************************************************************************************/
+/** The statistics keep their own copy of a format string, it need not outlive them
+ **********************************************************************************************************************/
+static void TestStatsFormatCopy(void)
+{
+  char format[] = "value %d\nnext line";
+  char string[32];
+  TinyStats stats;
+  int i;
+
+  TinyStatsReset();
+  TEST_CHECK(TinySNprintf(string, sizeof(string), format, 42) == 18);
+  memset(format, '?', sizeof(format) - 1);
+  TinyStatsSnapshot(&stats);
+  for(i = 0; i < TINY_PRINTF_STATS_FORMATS && stats.formats[i].format != format; i++) {
+  }
+  TEST_CHECK(i < TINY_PRINTF_STATS_FORMATS);
+  if(i < TINY_PRINTF_STATS_FORMATS) {
+    TEST_CHECK(strcmp(stats.formats[i].text, "value %d") == 0);
+  }
+}
+#endif
+
+int main(void)
+{
+#ifdef TINY_PRINTF_FLOAT
+  TestFloat();
+#endif
+  TestSpanSink();
+  TestCompile();
+  TestInteger();
+  TestRegister();
+  TestMeasure();
+  TestTruncate();
+  TestStringPrecision();
+  TestHexDump();
+  TestBatch();
+  TestFixed();
+#ifdef TINY_PRINTF_TIMESTAMP
+  TestTimestamp();
+#endif
+  TestStep();
+  TestBuilder();
+  TestBuilderError();
+#ifdef TINY_PRINTF_STATS
+  TestStatsCount();
+  TestStatsBuilderGrow();
+  TestStatsFormatCopy();
+#endif
+
+  TEST_RESULT();
+}
@@ -0,0 +1,67 @@
+/**********************************************************************************************************************/
+/** Checks of the hosted tests
+ ***********************************************************************************************************************
+ * Copyright 2001 Georges Menie
+ * https://www.menie.org/georges/embedded/small_printf_source_code.html
+ *
+ * Modified by Thuffir in 2019
+ * https://github.com/Thuffir/printf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Failed checks are printed to stdout, a test program returns the number of failed checks as exit code.
+ *
+ * @file tiny_test.h
+ *
+ **********************************************************************************************************************/
+
+#ifndef TINY_TEST_H_
+#define TINY_TEST_H_
+
+#include <stdio.h>
+#include <string.h>
+
+/// Number of failed checks
+static int testFailures;
+
+/// Report a failed check
+#define TEST_CHECK(condition)                                                                                          \
+  do {                                                                                                                 \
+    if(!(condition)) {                                                                                                 \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                             \
+      testFailures++;                                                                                                  \
+    }                                                                                                                  \
+  } while(0)
+
+/// Report a string differing from the expected one
+#define TEST_STRING(actual, expected)                                                                                  \
+  do {                                                                                                                 \
+    const char *testActual = (actual), *testExpected = (expected);                                                     \
+    if(strcmp(testActual, testExpected) != 0) {                                                                        \
+      printf("%s:%d: got \"%s\", expected \"%s\"\n", __FILE__, __LINE__, testActual, testExpected);                    \
+      testFailures++;                                                                                                  \
+    }                                                                                                                  \
+  } while(0)
+
+/// Print the result and return the number of failed checks from main()
+#define TEST_RESULT()                                                                                                  \
+  do {                                                                                                                 \
+    if(testFailures == 0) {                                                                                            \
+      printf("all checks passed\n");                                                                                   \
+    }                                                                                                                  \
+    return testFailures;                                                                                               \
+  } while(0)
+
+#endif //TINY_TEST_H_